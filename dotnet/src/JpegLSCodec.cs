@@ -272,6 +272,7 @@ private static void HandleResult(JpegLSError result)
                 case JpegLSError.InvalidJpeglsPresetParameterType:
                 case JpegLSError.JpeglsPresetExtendedParameterTypeNotSupported:
                 case JpegLSError.MissingEndOfSpiffDirectory:
+                case JpegLSError.RestartMarkerNotFound:
                 case JpegLSError.InvalidParameterWidth:
                 case JpegLSError.InvalidParameterHeight:
                 case JpegLSError.InvalidParameterComponentCount:
@@ -133,6 +133,11 @@ public enum JpegLSError
         /// </summary>
         MissingEndOfSpiffDirectory = 24,
 
+        /// <summary>
+        /// This error is returned when a restart marker is expected but not found, or when it has the wrong restart index.
+        /// </summary>
+        RestartMarkerNotFound = 25,
+
         /// <summary>
         /// The argument for the width parameter is outside the range [1, 65535].
         /// </summary>
@@ -12,6 +12,7 @@
 
 #include <memory>
 #include <utility>
+#include <vector>
 
 #else
 
@@ -68,6 +69,16 @@ charls_jpegls_decoder_create(void) CHARLS_NOEXCEPT;
 CHARLS_API_IMPORT_EXPORT void CHARLS_API_CALLING_CONVENTION
 charls_jpegls_decoder_destroy(IN_OPT_ const charls_jpegls_decoder* decoder) CHARLS_NOEXCEPT;
 
+/// <summary>
+/// Resets a JPEG-LS decoder instance to its initial state, a new source buffer can then be set to decode the next image.
+/// The maximum thread count and the internal buffers are kept: decoding a next image with the same frame info and
+/// coding parameters reuses the buffers of the previous image and requires no additional memory allocations.
+/// </summary>
+/// <param name="decoder">Reference to the decoder instance.</param>
+/// <returns>The result of the operation: success or a failure code.</returns>
+CHARLS_API_IMPORT_EXPORT charls_jpegls_errc CHARLS_API_CALLING_CONVENTION
+charls_jpegls_decoder_reset(IN_ charls_jpegls_decoder* decoder) CHARLS_NOEXCEPT CHARLS_ATTRIBUTE((nonnull));
+
 /// <summary>
 /// Set the reference to a source buffer that contains the encoded JPEG-LS byte stream data.
 /// This buffer needs to remain valid until the buffer is fully decoded.
@@ -174,6 +185,40 @@ charls_jpegls_decoder_get_destination_size(IN_ const charls_jpegls_decoder* deco
                                            uint32_t stride,
                                            OUT_ size_t* destination_size_bytes) CHARLS_NOEXCEPT CHARLS_ATTRIBUTE((nonnull));
 
+/// <summary>
+/// Configures the maximum number of threads the decoder may use. The default is 1 (decode on the calling thread).
+/// A value of 0 means that the decoder may use all the hardware threads that are available.
+/// </summary>
+/// <remarks>
+/// Images encoded with interleave mode none are decoded in parallel, every component scan is decoded by its own thread.
+/// Scans with restart intervals are decoded in parallel, every restart interval is decoded by its own thread.
+/// Other interleaved multi-component scans use a helper thread to convert and copy the decoded lines to the destination.
+/// </remarks>
+/// <param name="decoder">Reference to the decoder instance.</param>
+/// <param name="maximum_thread_count">The maximum number of threads, must be 0 or larger.</param>
+/// <returns>The result of the operation: success or a failure code.</returns>
+CHARLS_API_IMPORT_EXPORT charls_jpegls_errc CHARLS_API_CALLING_CONVENTION
+charls_jpegls_decoder_set_maximum_thread_count(IN_ charls_jpegls_decoder* decoder,
+                                               int32_t maximum_thread_count) CHARLS_NOEXCEPT CHARLS_ATTRIBUTE((nonnull));
+
+/// <summary>
+/// Configures the allocator the decoder uses for its internal buffers. The default allocator uses the global heap.
+/// </summary>
+/// <remarks>
+/// The allocator is used for the codec state and its buffers: lookup tables, line buffers, color transformation buffers and
+/// the line buffers of the multi-threaded pipeline.
+/// The instance itself, its stream reader, its small bookkeeping objects and the threads of the multi-threaded code paths use
+/// the global heap.
+/// Memory that was allocated with the previous allocator is released with that allocator when this function is called,
+/// an allocator must therefore remain valid until it is replaced or the instance is destroyed.
+/// </remarks>
+/// <param name="decoder">Reference to the decoder instance.</param>
+/// <param name="allocator">The allocator, the allocate and deallocate functions must both be set or both be null (default allocator).</param>
+/// <returns>The result of the operation: success or a failure code.</returns>
+CHARLS_API_IMPORT_EXPORT charls_jpegls_errc CHARLS_API_CALLING_CONVENTION
+charls_jpegls_decoder_set_allocator(IN_ charls_jpegls_decoder* decoder,
+                                    IN_ const charls_allocator* allocator) CHARLS_NOEXCEPT CHARLS_ATTRIBUTE((nonnull));
+
 /// <summary>
 /// Will decode the JPEG-LS byte stream from the source buffer into the destination buffer.
 /// </summary>
@@ -206,6 +251,16 @@ charls_jpegls_encoder_create(void) CHARLS_NOEXCEPT;
 CHARLS_API_IMPORT_EXPORT void CHARLS_API_CALLING_CONVENTION
 charls_jpegls_encoder_destroy(IN_OPT_ const charls_jpegls_encoder* encoder) CHARLS_NOEXCEPT;
 
+/// <summary>
+/// Resets a JPEG-LS encoder instance to its initial state, a new destination buffer can then be set to encode the next image.
+/// The configuration (frame info, coding parameters, etc.) and the internal buffers are kept: encoding a next image with the
+/// same frame info and coding parameters reuses the buffers of the previous image and requires no additional memory allocations.
+/// </summary>
+/// <param name="encoder">Reference to the encoder instance.</param>
+/// <returns>The result of the operation: success or a failure code.</returns>
+CHARLS_API_IMPORT_EXPORT charls_jpegls_errc CHARLS_API_CALLING_CONVENTION
+charls_jpegls_encoder_reset(IN_ charls_jpegls_encoder* encoder) CHARLS_NOEXCEPT CHARLS_ATTRIBUTE((nonnull));
+
 /// <summary>
 /// Configures the frame that needs to be encoded. This information will be written to the Start of Frame segment.
 /// </summary>
@@ -262,6 +317,91 @@ CHARLS_API_IMPORT_EXPORT charls_jpegls_errc CHARLS_API_CALLING_CONVENTION
 charls_jpegls_encoder_set_color_transformation(IN_ charls_jpegls_encoder* encoder,
                                                charls_color_transformation color_transformation) CHARLS_NOEXCEPT CHARLS_ATTRIBUTE((nonnull));
 
+/// <summary>
+/// Configures the restart interval: the number of lines between restart (RSTm) markers. The default is 0 (no restart markers).
+/// </summary>
+/// <remarks>
+/// Restart markers make it possible to recover from transmission errors and to decode independent parts of a scan.
+/// </remarks>
+/// <param name="encoder">Reference to the encoder instance.</param>
+/// <param name="restart_interval">The number of lines between restart markers, 0 means no restart markers.</param>
+/// <returns>The result of the operation: success or a failure code.</returns>
+CHARLS_API_IMPORT_EXPORT charls_jpegls_errc CHARLS_API_CALLING_CONVENTION
+charls_jpegls_encoder_set_restart_interval(IN_ charls_jpegls_encoder* encoder,
+                                           uint32_t restart_interval) CHARLS_NOEXCEPT CHARLS_ATTRIBUTE((nonnull));
+
+/// <summary>
+/// Configures the maximum number of threads the encoder may use. The default is 1 (encode on the calling thread).
+/// A value of 0 means that the encoder may use all the hardware threads that are available.
+/// </summary>
+/// <remarks>
+/// Images with interleave mode none are encoded in parallel, every component scan is encoded by its own thread.
+/// Images with a restart interval are encoded in parallel in horizontal stripes of restart intervals.
+/// Other interleaved multi-component images use a helper thread to copy and color transform the source lines.
+/// </remarks>
+/// <param name="encoder">Reference to the encoder instance.</param>
+/// <param name="maximum_thread_count">The maximum number of threads, must be 0 or larger.</param>
+/// <returns>The result of the operation: success or a failure code.</returns>
+CHARLS_API_IMPORT_EXPORT charls_jpegls_errc CHARLS_API_CALLING_CONVENTION
+charls_jpegls_encoder_set_maximum_thread_count(IN_ charls_jpegls_encoder* encoder,
+                                               int32_t maximum_thread_count) CHARLS_NOEXCEPT CHARLS_ATTRIBUTE((nonnull));
+
+/// <summary>
+/// Configures the allocator the encoder uses for its internal buffers. The default allocator uses the global heap.
+/// </summary>
+/// <remarks>
+/// The allocator is used for the codec state and its buffers: lookup tables, line buffers, color transformation buffers,
+/// the buffers of the multi-threaded code paths and the error metrics.
+/// The instance itself, its small bookkeeping objects and the threads of the multi-threaded code paths use the global heap.
+/// Memory that was allocated with the previous allocator is released with that allocator when this function is called,
+/// an allocator must therefore remain valid until it is replaced or the instance is destroyed.
+/// </remarks>
+/// <param name="encoder">Reference to the encoder instance.</param>
+/// <param name="allocator">The allocator, the allocate and deallocate functions must both be set or both be null (default allocator).</param>
+/// <returns>The result of the operation: success or a failure code.</returns>
+CHARLS_API_IMPORT_EXPORT charls_jpegls_errc CHARLS_API_CALLING_CONVENTION
+charls_jpegls_encoder_set_allocator(IN_ charls_jpegls_encoder* encoder,
+                                    IN_ const charls_allocator* allocator) CHARLS_NOEXCEPT CHARLS_ATTRIBUTE((nonnull));
+
+/// <summary>
+/// Configures the encoder to collect the error metrics (source sample - reconstructed sample) while encoding. The default is false.
+/// </summary>
+/// <remarks>
+/// The error metrics make it possible to evaluate the quality of a near-lossless encoding without decoding the result.
+/// When a color transformation is used, the metrics describe the transformed components.
+/// </remarks>
+/// <param name="encoder">Reference to the encoder instance.</param>
+/// <param name="collect_error_metrics">True when the error metrics should be collected.</param>
+/// <returns>The result of the operation: success or a failure code.</returns>
+CHARLS_API_IMPORT_EXPORT charls_jpegls_errc CHARLS_API_CALLING_CONVENTION
+charls_jpegls_encoder_set_collect_error_metrics(IN_ charls_jpegls_encoder* encoder,
+                                                bool collect_error_metrics) CHARLS_NOEXCEPT CHARLS_ATTRIBUTE((nonnull));
+
+/// <summary>
+/// Returns the error metrics of a component, collected by the last successful encode operation.
+/// </summary>
+/// <param name="encoder">Reference to the encoder instance.</param>
+/// <param name="component">The index of the component, range [0, component count).</param>
+/// <param name="error_metrics">Reference to the error metrics that will be set when the functions returns.</param>
+/// <returns>The result of the operation: success or a failure code.</returns>
+CHARLS_API_IMPORT_EXPORT charls_jpegls_errc CHARLS_API_CALLING_CONVENTION
+charls_jpegls_encoder_get_component_error_metrics(IN_ const charls_jpegls_encoder* encoder, int32_t component,
+                                                  OUT_ charls_component_error_metrics* error_metrics) CHARLS_NOEXCEPT CHARLS_ATTRIBUTE((nonnull));
+
+/// <summary>
+/// Returns the histogram of the error values of a component, collected by the last successful encode operation.
+/// Entry i contains the number of samples with error value i - NEAR, the error value is the source sample minus
+/// the reconstructed sample (error = source - reconstructed): entry 0 counts the samples reconstructed NEAR too high.
+/// </summary>
+/// <param name="encoder">Reference to the encoder instance.</param>
+/// <param name="component">The index of the component, range [0, component count).</param>
+/// <param name="histogram">Reference to the buffer that will receive the histogram.</param>
+/// <param name="histogram_size">The number of entries in the buffer, must be at least 2 * NEAR + 1.</param>
+/// <returns>The result of the operation: success or a failure code.</returns>
+CHARLS_API_IMPORT_EXPORT charls_jpegls_errc CHARLS_API_CALLING_CONVENTION
+charls_jpegls_encoder_get_error_histogram(IN_ const charls_jpegls_encoder* encoder, int32_t component,
+                                          OUT_ uint64_t* histogram, size_t histogram_size) CHARLS_NOEXCEPT CHARLS_ATTRIBUTE((nonnull));
+
 /// <summary>
 /// Returns the size in bytes, that the encoder expects are needed to hold the encoded image.
 /// </summary>
@@ -481,6 +621,16 @@ class jpegls_decoder final
     jpegls_decoder& operator=(const jpegls_decoder&) = delete;
     jpegls_decoder& operator=(jpegls_decoder&&) noexcept = default;
 
+    /// <summary>
+    /// Resets the decoder to its initial state, a new source can then be set to decode the next image.
+    /// The internal buffers are kept and reused when the next image has the same frame info and coding parameters.
+    /// </summary>
+    jpegls_decoder& reset()
+    {
+        check_jpegls_errc(charls_jpegls_decoder_reset(decoder_.get()));
+        return *this;
+    }
+
     /// <summary>
     /// Set the reference to a source buffer that contains the encoded JPEG-LS byte stream data.
     /// This buffer needs to remain valid until the stream is fully decoded.
@@ -618,6 +768,29 @@ class jpegls_decoder final
         return size_in_bytes;
     }
 
+    /// <summary>
+    /// Configures the maximum number of threads the decoder may use. The default is 1 (decode on the calling thread).
+    /// A value of 0 means that the decoder may use all the hardware threads that are available.
+    /// Images encoded with interleave mode none or with restart intervals can be decoded in parallel.
+    /// </summary>
+    /// <param name="maximum_thread_count">The maximum number of threads, must be 0 or larger.</param>
+    jpegls_decoder& maximum_thread_count(const int32_t maximum_thread_count)
+    {
+        check_jpegls_errc(charls_jpegls_decoder_set_maximum_thread_count(decoder_.get(), maximum_thread_count));
+        return *this;
+    }
+
+    /// <summary>
+    /// Configures the allocator the decoder uses for its internal buffers (codec state, line buffers).
+    /// The allocator must remain valid until it is replaced or the decoder is destroyed.
+    /// </summary>
+    /// <param name="allocator">The allocator, the allocate and deallocate functions must both be set or both be null.</param>
+    jpegls_decoder& allocator(const charls::allocator& allocator)
+    {
+        check_jpegls_errc(charls_jpegls_decoder_set_allocator(decoder_.get(), &allocator));
+        return *this;
+    }
+
     /// <summary>
     /// Will decode the JPEG-LS byte stream set with source into the destination buffer.
     /// </summary>
@@ -710,6 +883,16 @@ class jpegls_encoder final
     jpegls_encoder& operator=(const jpegls_encoder&) = delete;
     jpegls_encoder& operator=(jpegls_encoder&&) noexcept = default;
 
+    /// <summary>
+    /// Resets the encoder to its initial state, a new destination can then be set to encode the next image.
+    /// The configuration and the internal buffers are kept and reused when the next image has the same frame info and coding parameters.
+    /// </summary>
+    jpegls_encoder& reset()
+    {
+        check_jpegls_errc(charls_jpegls_encoder_reset(encoder_.get()));
+        return *this;
+    }
+
     /// <summary>
     /// Configures the frame that needs to be encoded.
     /// This information will be written to the Start of Frame (SOF) segment during the encode phase.
@@ -767,6 +950,75 @@ class jpegls_encoder final
         return *this;
     }
 
+    /// <summary>
+    /// Configures the restart interval: the number of lines between restart (RSTm) markers. The default is 0 (no restart markers).
+    /// </summary>
+    /// <param name="restart_interval">The number of lines between restart markers, 0 means no restart markers.</param>
+    jpegls_encoder& restart_interval(const uint32_t restart_interval)
+    {
+        check_jpegls_errc(charls_jpegls_encoder_set_restart_interval(encoder_.get(), restart_interval));
+        return *this;
+    }
+
+    /// <summary>
+    /// Configures the maximum number of threads the encoder may use. The default is 1 (encode on the calling thread).
+    /// A value of 0 means that the encoder may use all the hardware threads that are available.
+    /// Images with interleave mode none or with a restart interval can be encoded in parallel.
+    /// </summary>
+    /// <param name="maximum_thread_count">The maximum number of threads, must be 0 or larger.</param>
+    jpegls_encoder& maximum_thread_count(const int32_t maximum_thread_count)
+    {
+        check_jpegls_errc(charls_jpegls_encoder_set_maximum_thread_count(encoder_.get(), maximum_thread_count));
+        return *this;
+    }
+
+    /// <summary>
+    /// Configures the allocator the encoder uses for its internal buffers (codec state, line buffers).
+    /// The allocator must remain valid until it is replaced or the encoder is destroyed.
+    /// </summary>
+    /// <param name="allocator">The allocator, the allocate and deallocate functions must both be set or both be null.</param>
+    jpegls_encoder& allocator(const charls::allocator& allocator)
+    {
+        check_jpegls_errc(charls_jpegls_encoder_set_allocator(encoder_.get(), &allocator));
+        return *this;
+    }
+
+    /// <summary>
+    /// Configures the encoder to collect the error metrics (source sample - reconstructed sample) while encoding. The default is false.
+    /// </summary>
+    /// <param name="collect_error_metrics">True when the error metrics should be collected.</param>
+    jpegls_encoder& collect_error_metrics(const bool collect_error_metrics)
+    {
+        check_jpegls_errc(charls_jpegls_encoder_set_collect_error_metrics(encoder_.get(), collect_error_metrics));
+        return *this;
+    }
+
+    /// <summary>
+    /// Returns the error metrics of a component, collected by the last successful encode operation.
+    /// </summary>
+    /// <param name="component">The index of the component, range [0, component count).</param>
+    /// <returns>The error metrics of the component.</returns>
+    CHARLS_NO_DISCARD component_error_metrics error_metrics(const int32_t component) const
+    {
+        component_error_metrics metrics;
+        check_jpegls_errc(charls_jpegls_encoder_get_component_error_metrics(encoder_.get(), component, &metrics));
+        return metrics;
+    }
+
+    /// <summary>
+    /// Returns the histogram of the error values of a component, collected by the last successful encode operation.
+    /// Entry i contains the number of samples with error value i - NEAR, the error value is the source sample minus
+    /// the reconstructed sample (error = source - reconstructed): entry 0 counts the samples reconstructed NEAR too high.
+    /// </summary>
+    /// <param name="component">The index of the component, range [0, component count).</param>
+    /// <returns>The histogram of the error values, with 2 * NEAR + 1 entries.</returns>
+    CHARLS_NO_DISCARD std::vector<uint64_t> error_histogram(const int32_t component) const
+    {
+        std::vector<uint64_t> histogram(static_cast<size_t>(2 * error_metrics(component).near_lossless + 1));
+        check_jpegls_errc(charls_jpegls_encoder_get_error_histogram(encoder_.get(), component, histogram.data(), histogram.size()));
+        return histogram;
+    }
+
     /// <summary>
     /// Returns the size in bytes, that the encoder expects are needed to hold the encoded image.
     /// </summary>
@@ -16,6 +16,7 @@ namespace charls {
 namespace impl {
 
 #else
+#include <stddef.h>
 #include <stdint.h>
 #endif
 
@@ -50,6 +51,7 @@ enum charls_jpegls_errc
     CHARLS_JPEGLS_ERRC_INVALID_JPEGLS_PRESET_PARAMETER_TYPE = 22,
     CHARLS_JPEGLS_ERRC_JPEGLS_PRESET_EXTENDED_PARAMETER_TYPE_NOT_SUPPORTED = 23,
     CHARLS_JPEGLS_ERRC_MISSING_END_OF_SPIFF_DIRECTORY = 24,
+    CHARLS_JPEGLS_ERRC_RESTART_MARKER_NOT_FOUND = 25,
     CHARLS_JPEGLS_ERRC_INVALID_ARGUMENT_WIDTH = 100,
     CHARLS_JPEGLS_ERRC_INVALID_ARGUMENT_HEIGHT = 101,
     CHARLS_JPEGLS_ERRC_INVALID_ARGUMENT_COMPONENT_COUNT = 102,
@@ -283,6 +285,11 @@ enum class jpegls_errc
     /// </summary>
     missing_end_of_spiff_directory = impl::CHARLS_JPEGLS_ERRC_MISSING_END_OF_SPIFF_DIRECTORY,
 
+    /// <summary>
+    /// This error is returned when a restart marker is expected but not found, or when it has the wrong restart index.
+    /// </summary>
+    restart_marker_not_found = impl::CHARLS_JPEGLS_ERRC_RESTART_MARKER_NOT_FOUND,
+
     /// <summary>
     /// The argument for the width parameter is outside the range [1, 65535].
     /// </summary>
@@ -846,6 +853,82 @@ struct charls_jpegls_pc_parameters CHARLS_FINAL
     int32_t reset_value;
 };
 
+/// <summary>
+/// Defines the error metrics of a component, collected by the encoder while encoding.
+/// The error of a sample is the source sample minus the sample that the decoder will reconstruct (error = source - reconstructed):
+/// a positive error means that the reconstructed sample is smaller than the source sample.
+/// </summary>
+/// <remark>
+/// The errors are measured on the encoded samples: when a color transformation is used, these are the transformed samples.
+/// </remark>
+struct charls_component_error_metrics CHARLS_FINAL
+{
+    /// <summary>
+    /// Number of samples of the component.
+    /// </summary>
+    uint64_t sample_count;
+
+    /// <summary>
+    /// Sum of the squared errors of all samples.
+    /// </summary>
+    uint64_t sum_squared_error;
+
+    /// <summary>
+    /// Peak signal to noise ratio in dB, computed with the maximum sample value. Infinity when there is no error.
+    /// </summary>
+    double peak_signal_to_noise_ratio;
+
+    /// <summary>
+    /// Largest absolute error of all samples, range [0, near_lossless].
+    /// </summary>
+    int32_t maximum_error;
+
+    /// <summary>
+    /// The NEAR parameter used to encode the component. The error histogram of the component has 2 * near_lossless + 1 entries.
+    /// </summary>
+    int32_t near_lossless;
+};
+
+/// <summary>
+/// Function that allocates memory for the internal buffers of an encoder or decoder.
+/// </summary>
+/// <param name="user_context">The user_context member of the allocator.</param>
+/// <param name="size">Size of the memory block in bytes, always larger than 0.</param>
+/// <param name="alignment">Required alignment of the memory block, a power of 2 that is not larger than the alignment of max_align_t.</param>
+/// <returns>Reference to the allocated memory block, or a null pointer when the allocation fails.</returns>
+typedef void*(CHARLS_API_CALLING_CONVENTION* charls_allocate_function)(void* user_context, size_t size, size_t alignment);
+
+/// <summary>
+/// Function that releases a memory block that was allocated by the allocate function of the same allocator.
+/// </summary>
+/// <param name="user_context">The user_context member of the allocator.</param>
+/// <param name="memory">Reference to the memory block, never a null pointer.</param>
+/// <param name="size">Size of the memory block in bytes, as passed to the allocate function.</param>
+/// <param name="alignment">Alignment of the memory block, as passed to the allocate function.</param>
+typedef void(CHARLS_API_CALLING_CONVENTION* charls_deallocate_function)(void* user_context, void* memory, size_t size, size_t alignment);
+
+/// <summary>
+/// Defines a custom allocator for the internal buffers of an encoder or decoder instance (codec state, line and stream buffers).
+/// The functions may be called concurrently from multiple threads when the instance uses multiple threads.
+/// </summary>
+struct charls_allocator CHARLS_FINAL
+{
+    /// <summary>
+    /// Function that allocates a memory block.
+    /// </summary>
+    charls_allocate_function allocate;
+
+    /// <summary>
+    /// Function that releases a memory block.
+    /// </summary>
+    charls_deallocate_function deallocate;
+
+    /// <summary>
+    /// Value that is passed as first argument to the allocate and deallocate functions.
+    /// </summary>
+    void* user_context;
+};
+
 /// <summary>
 /// Defines the JPEG-LS preset coding parameters as defined in ISO/IEC 14495-1, C.2.4.1.1.
 /// JPEG-LS defines a default set of parameters, but custom parameters can be used.
@@ -1010,10 +1093,13 @@ namespace charls {
 using spiff_header = charls_spiff_header;
 using frame_info = charls_frame_info;
 using jpegls_pc_parameters = charls_jpegls_pc_parameters;
+using component_error_metrics = charls_component_error_metrics;
+using allocator = charls_allocator;
 
 static_assert(sizeof(spiff_header) == 40, "size of struct is incorrect, check padding settings");
 static_assert(sizeof(frame_info) == 16, "size of struct is incorrect, check padding settings");
 static_assert(sizeof(jpegls_pc_parameters) == 20, "size of struct is incorrect, check padding settings");
+static_assert(sizeof(component_error_metrics) == 32, "size of struct is incorrect, check padding settings");
 
 } // namespace charls
 
@@ -1022,5 +1108,7 @@ static_assert(sizeof(jpegls_pc_parameters) == 20, "size of struct is incorrect,
 typedef struct charls_spiff_header charls_spiff_header;
 typedef struct charls_frame_info charls_frame_info;
 typedef struct charls_jpegls_pc_parameters charls_jpegls_pc_parameters;
+typedef struct charls_component_error_metrics charls_component_error_metrics;
+typedef struct charls_allocator charls_allocator;
 
 #endif
@@ -26,10 +26,26 @@ struct charls_jpegls_decoder final
         size_ = source_size_bytes;
 
         ByteStreamInfo source{FromByteArrayConst(source_buffer_, size_)};
-        reader_ = std::make_unique<JpegStreamReader>(source);
+        if (reader_)
+        {
+            reader_->Reset(source);
+        }
+        else
+        {
+            reader_ = std::make_unique<JpegStreamReader>(source);
+            reader_->SetAllocator(allocator_);
+        }
         state_ = state::source_set;
     }
 
+    // Keeps the reader, source() reuses it with its codec cache for the next image.
+    void reset() noexcept
+    {
+        source_buffer_ = nullptr;
+        size_ = 0;
+        state_ = state::initial;
+    }
+
     bool read_header(OUT_ spiff_header* spiff_header)
     {
         if (state_ != state::source_set)
@@ -130,6 +146,7 @@ struct charls_jpegls_decoder final
             throw_jpegls_error(jpegls_errc::invalid_operation);
 
         const ByteStreamInfo destination = FromByteArray(destination_buffer, destination_size_bytes);
+        reader_->SetMaximumThreadCount(maximum_thread_count_);
         reader_->Read(destination, stride);
     }
 
@@ -143,6 +160,26 @@ struct charls_jpegls_decoder final
         reader_->SetRect(rect);
     }
 
+    void maximum_thread_count(const int32_t maximum_thread_count)
+    {
+        if (maximum_thread_count < 0)
+            throw_jpegls_error(jpegls_errc::invalid_argument);
+
+        maximum_thread_count_ = static_cast<uint32_t>(maximum_thread_count);
+    }
+
+    void allocator(const charls_allocator& allocator)
+    {
+        if (!allocator.allocate != !allocator.deallocate)
+            throw_jpegls_error(jpegls_errc::invalid_argument);
+
+        allocator_ = allocator;
+        if (reader_)
+        {
+            reader_->SetAllocator(allocator_);
+        }
+    }
+
 private:
     enum class state
     {
@@ -158,6 +195,8 @@ struct charls_jpegls_decoder final
     unique_ptr<JpegStreamReader> reader_;
     const void* source_buffer_{};
     size_t size_{};
+    uint32_t maximum_thread_count_{1};
+    charls_allocator allocator_{};
 };
 
 
@@ -177,6 +216,18 @@ charls_jpegls_decoder_destroy(IN_OPT_ const charls_jpegls_decoder* decoder) noex
     delete decoder;                              // NOLINT(cppcoreguidelines-owning-memory)
 }
 
+jpegls_errc CHARLS_API_CALLING_CONVENTION
+charls_jpegls_decoder_reset(IN_ charls_jpegls_decoder* decoder) noexcept
+try
+{
+    check_pointer(decoder)->reset();
+    return jpegls_errc::success;
+}
+catch (...)
+{
+    return to_jpegls_errc();
+}
+
 jpegls_errc CHARLS_API_CALLING_CONVENTION
 charls_jpegls_decoder_set_source_buffer(IN_ charls_jpegls_decoder* decoder,
                                         IN_READS_BYTES_(source_size_bytes) const void* source_buffer,
@@ -285,6 +336,31 @@ catch (...)
     return to_jpegls_errc();
 }
 
+jpegls_errc CHARLS_API_CALLING_CONVENTION
+charls_jpegls_decoder_set_maximum_thread_count(IN_ charls_jpegls_decoder* decoder,
+                                               const int32_t maximum_thread_count) noexcept
+try
+{
+    check_pointer(decoder)->maximum_thread_count(maximum_thread_count);
+    return jpegls_errc::success;
+}
+catch (...)
+{
+    return to_jpegls_errc();
+}
+
+jpegls_errc CHARLS_API_CALLING_CONVENTION
+charls_jpegls_decoder_set_allocator(IN_ charls_jpegls_decoder* decoder, IN_ const charls_allocator* allocator) noexcept
+try
+{
+    check_pointer(decoder)->allocator(*check_pointer(allocator));
+    return jpegls_errc::success;
+}
+catch (...)
+{
+    return to_jpegls_errc();
+}
+
 jpegls_errc CHARLS_API_CALLING_CONVENTION
 charls_jpegls_decoder_decode_to_buffer(IN_ const charls_jpegls_decoder* decoder,
                                        OUT_WRITES_BYTES_(destination_size_bytes) void* destination_buffer,
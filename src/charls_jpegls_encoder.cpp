@@ -4,17 +4,22 @@
 #include <charls/charls.h>
 
 #include "encoder_strategy.h"
+#include "error_metrics.h"
 #include "jls_codec_factory.h"
 #include "jpeg_stream_writer.h"
 #include "jpegls_preset_coding_parameters.h"
+#include "parallel_for.h"
+#include "pipelined_process_line.h"
 #include "util.h"
 
+#include <algorithm>
 #include <cassert>
 #include <new>
+#include <vector>
 
 using namespace charls;
 using impl::throw_jpegls_error;
-using std::unique_ptr;
+using std::vector;
 
 struct charls_jpegls_encoder final
 {
@@ -78,6 +83,54 @@ struct charls_jpegls_encoder final
         color_transformation_ = color_transformation;
     }
 
+    void maximum_thread_count(const int32_t maximum_thread_count)
+    {
+        if (maximum_thread_count < 0)
+            throw_jpegls_error(jpegls_errc::invalid_argument);
+
+        maximum_thread_count_ = static_cast<uint32_t>(maximum_thread_count);
+    }
+
+    // The codec of the last scan is released first, with the allocator it was created with.
+    void allocator(const charls_allocator& allocator)
+    {
+        if (!allocator.allocate != !allocator.deallocate)
+            throw_jpegls_error(jpegls_errc::invalid_argument);
+
+        // Release everything that was allocated with the previous allocator.
+        codec_cache_.Clear();
+        parallel_codec_caches_ = codec_cache_list(allocator_adapter<JlsCodecCache<EncoderStrategy>>(allocator));
+        scratch_buffers_ = scratch_buffer_list(allocator_adapter<allocated_vector<uint8_t>>(allocator));
+        error_metrics_.reset();
+        error_metrics_available_ = false;
+        allocator_ = allocator;
+    }
+
+    void restart_interval(const uint32_t restart_interval) noexcept
+    {
+        restart_interval_ = restart_interval;
+    }
+
+    void collect_error_metrics(const bool collect) noexcept
+    {
+        collect_error_metrics_ = collect;
+    }
+
+    charls_component_error_metrics component_error_metrics(const int32_t component) const
+    {
+        return check_error_metrics(component).get_component_metrics(component);
+    }
+
+    void error_histogram(const int32_t component, OUT_ uint64_t* histogram, const size_t histogram_size) const
+    {
+        const error_metrics& metrics{check_error_metrics(component)};
+        if (histogram_size < metrics.histogram_size())
+            throw_jpegls_error(jpegls_errc::invalid_argument);
+
+        const uint64_t* component_histogram{metrics.component_histogram(component)};
+        std::copy(component_histogram, component_histogram + metrics.histogram_size(), histogram);
+    }
+
     size_t estimated_destination_size() const
     {
         if (!is_frame_info_configured())
@@ -85,7 +138,7 @@ struct charls_jpegls_encoder final
 
         return static_cast<size_t>(frame_info_.width) * frame_info_.height *
                    frame_info_.component_count * (frame_info_.bits_per_sample < 9 ? 1 : 2) +
-               1024 + spiff_header_size_in_bytes;
+               1024 + spiff_header_size_in_bytes + estimated_restart_markers_size();
     }
 
     void write_spiff_header(const spiff_header& spiff_header)
@@ -182,14 +235,30 @@ struct charls_jpegls_encoder final
             writer_.WriteJpegLSPresetParametersSegment(preset);
         }
 
+        if (restart_interval_ != 0)
+        {
+            writer_.WriteDefineRestartIntervalSegment(restart_interval_);
+        }
+
+        error_metrics_available_ = false;
+        if (collect_error_metrics_)
+        {
+            error_metrics_ = allocate_unique<error_metrics>(allocator_, create_error_metrics(frame_info_.component_count));
+        }
+
         ByteStreamInfo sourceInfo = FromByteArrayConst(source, source_size_bytes);
-        if (interleave_mode_ == charls::interleave_mode::none)
+        if (interleave_mode_ == charls::interleave_mode::none && frame_info_.component_count > 1 &&
+            effective_thread_count(maximum_thread_count_) > 1)
+        {
+            encode_scans_in_parallel(sourceInfo, stride);
+        }
+        else if (interleave_mode_ == charls::interleave_mode::none)
         {
             const int32_t byteCountComponent = frame_info_.width * frame_info_.height * ((frame_info_.bits_per_sample + 7) / 8);
             for (int32_t component = 0; component < frame_info_.component_count; ++component)
             {
                 writer_.WriteStartOfScanSegment(1, near_lossless_, interleave_mode_);
-                encode_scan(sourceInfo, stride, 1);
+                encode_scan(sourceInfo, stride, 1, component);
 
                 // Synchronize the source stream (EncodeScan works on a local copy)
                 SkipBytes(sourceInfo, byteCountComponent);
@@ -198,10 +267,11 @@ struct charls_jpegls_encoder final
         else
         {
             writer_.WriteStartOfScanSegment(frame_info_.component_count, near_lossless_, interleave_mode_);
-            encode_scan(sourceInfo, stride, frame_info_.component_count);
+            encode_scan(sourceInfo, stride, frame_info_.component_count, 0);
         }
 
         writer_.WriteEndOfImage();
+        error_metrics_available_ = collect_error_metrics_;
     }
 
     size_t bytes_written() const noexcept
@@ -209,6 +279,15 @@ struct charls_jpegls_encoder final
         return writer_.GetBytesWritten();
     }
 
+    // The configuration and the codec of the last scan are kept: encoding a next image with the same
+    // frame info and parameters reuses the codec and its buffers.
+    void reset() noexcept
+    {
+        writer_.Reset();
+        error_metrics_available_ = false;
+        state_ = state::initial;
+    }
+
 private:
     enum class state
     {
@@ -223,21 +302,317 @@ struct charls_jpegls_encoder final
         return frame_info_.width != 0;
     }
 
-    void encode_scan(const ByteStreamInfo source, const uint32_t stride, const int32_t component_count)
+    void encode_scan(const ByteStreamInfo source, const uint32_t stride, const int32_t component_count, const int32_t first_component)
     {
-        const charls::frame_info frame_info{frame_info_.width, frame_info_.height, frame_info_.bits_per_sample, component_count};
+        if (restart_interval_ != 0 && restart_interval_ < frame_info_.height &&
+            effective_thread_count(maximum_thread_count_) > 1)
+        {
+            encode_scan_in_stripes(source, stride, component_count, first_component);
+            return;
+        }
 
-        auto codec = JlsCodecFactory<EncoderStrategy>().CreateCodec(frame_info,
-                                                                    {near_lossless_, interleave_mode_, color_transformation_, false},
-                                                                    preset_coding_parameters_);
-        unique_ptr<ProcessLine> processLine(codec->CreateProcess(source, stride));
-        ByteStreamInfo destination{writer_.OutputStream()};
-        const size_t bytesWritten = codec->EncodeScan(move(processLine), destination);
+        const size_t bytesWritten = encode_lines(source, stride, component_count, frame_info_.height, restart_interval_,
+                                                 writer_.OutputStream(), error_metrics_.get(), first_component,
+                                                 can_pipeline_input(component_count), codec_cache_);
 
         // Synchronize the destination encapsulated in the writer (EncodeScan works on a local copy)
         writer_.Seek(bytesWritten);
     }
 
+    size_t encode_scan(const ByteStreamInfo source, const uint32_t stride, const int32_t component_count, const int32_t first_component,
+                       const ByteStreamInfo destination, error_metrics* metrics, JlsCodecCache<EncoderStrategy>& codec_cache) const
+    {
+        return encode_lines(source, stride, component_count, frame_info_.height, restart_interval_, destination,
+                            metrics, first_component, can_pipeline_input(component_count), codec_cache);
+    }
+
+    // Only the input of interleaved multi-component lines (color transform, de-interleaving) is worth a helper thread.
+    bool can_pipeline_input(const int32_t component_count) const noexcept
+    {
+        return interleave_mode_ != charls::interleave_mode::none && component_count > 1 &&
+               effective_thread_count(maximum_thread_count_) > 1;
+    }
+
+    // The codec in codec_cache is reused by the next scan with the same frame info and parameters.
+    size_t encode_lines(const ByteStreamInfo source, const uint32_t stride, const int32_t component_count,
+                        const uint32_t height, const uint32_t restart_interval, ByteStreamInfo destination,
+                        error_metrics* metrics, const int32_t first_component, const bool pipeline_input,
+                        JlsCodecCache<EncoderStrategy>& codec_cache) const
+    {
+        const charls::frame_info frame_info{frame_info_.width, height, frame_info_.bits_per_sample, component_count};
+        const coding_parameters parameters{near_lossless_, interleave_mode_, color_transformation_, false, restart_interval};
+
+        EncoderStrategy& codec = codec_cache.GetCodec(frame_info, parameters, preset_coding_parameters_, allocator_);
+        codec.CollectErrorMetrics(metrics, first_component);
+        codec.SetFirstRestartMarkerIndex(0); // A cached codec may have encoded a stripe that started at another restart interval.
+
+        allocated_ptr<ProcessLine> processLine(codec.CreateProcess(source, stride));
+        if (!pipeline_input)
+            return codec.EncodeScan(move(processLine), destination);
+
+        // The codec owns the pipeline, it remains valid until the codec is destroyed or encodes the next scan.
+        auto pipeline = allocate_unique<PipelinedProcessLine>(allocator_, move(processLine), frame_info, parameters, allocator_);
+        PipelinedProcessLine& pipelineReference = *pipeline;
+        size_t bytesWritten;
+        try
+        {
+            bytesWritten = codec.EncodeScan(move(pipeline), destination);
+        }
+        catch (...)
+        {
+            // The helper thread may not read from the source after the encoder has failed.
+            pipelineReference.Stop();
+            throw;
+        }
+        pipelineReference.Flush();
+        return bytesWritten;
+    }
+
+    // The coding state is reset at every restart marker: horizontal stripes of consecutive restart intervals are encoded
+    // as separate images by multiple threads and concatenated with RSTm markers. The first stripe is encoded directly
+    // into the destination, the others into scratch buffers. The result is identical to encoding the scan with a single thread.
+    // Every stripe collects its error metrics separately, they are added to the error metrics of the image afterwards.
+    void encode_scan_in_stripes(const ByteStreamInfo source, const uint32_t stride, const int32_t component_count, const int32_t first_component)
+    {
+        const size_t intervalCount = (frame_info_.height + restart_interval_ - 1) / restart_interval_;
+        const size_t intervalsPerStripe = (intervalCount + maximum_stripe_count() - 1) / maximum_stripe_count();
+        const size_t stripeCount = (intervalCount + intervalsPerStripe - 1) / intervalsPerStripe;
+        const size_t bytesPerLine = static_cast<size_t>(frame_info_.width) * component_count * ((frame_info_.bits_per_sample + 7) / 8);
+        const ByteStreamInfo destination{writer_.OutputStream()};
+
+        add_scratch_buffers(stripeCount - 1);
+        add_parallel_codec_caches(stripeCount);
+        vector<size_t> stripeSizes(stripeCount);
+        allocated_vector<error_metrics> stripeMetrics{allocator_adapter<error_metrics>(allocator_)};
+        if (error_metrics_)
+        {
+            stripeMetrics.resize(stripeCount, create_error_metrics(component_count));
+        }
+
+        parallel_for(stripeCount, maximum_thread_count_, [&](const size_t stripe) {
+            const size_t firstInterval = stripe * intervalsPerStripe;
+            const size_t lastInterval = std::min(intervalCount, firstInterval + intervalsPerStripe);
+            error_metrics* metrics = stripeMetrics.empty() ? nullptr : &stripeMetrics[stripe];
+            if (stripe == 0)
+            {
+                stripeSizes[stripe] = encode_stripe(source, stride, component_count, firstInterval, lastInterval, destination, metrics,
+                                                    parallel_codec_caches_[stripe]);
+                return;
+            }
+
+            // Start with a buffer that fits the typical case and retry with the remaining destination size if it is too small.
+            size_t stripeBufferSize = std::min(destination.count, (lastInterval - firstInterval) * (restart_interval_ * bytesPerLine + 1024));
+            for (;;)
+            {
+                try
+                {
+                    stripeSizes[stripe] = encode_stripe(source, stride, component_count, firstInterval, lastInterval,
+                                                        scratch_buffer(stripe - 1, stripeBufferSize), metrics, parallel_codec_caches_[stripe]);
+                    return;
+                }
+                catch (const jpegls_error& error)
+                {
+                    if (error.code() != jpegls_errc::destination_buffer_too_small || stripeBufferSize == destination.count)
+                        throw;
+
+                    stripeBufferSize = destination.count;
+                    if (metrics)
+                    {
+                        *metrics = create_error_metrics(component_count);
+                    }
+                }
+            }
+        });
+
+        writer_.Seek(stripeSizes[0]);
+        for (size_t stripe = 1; stripe < stripeCount; ++stripe)
+        {
+            writer_.WriteBytes(scratch_buffers_[stripe - 1].data(), stripeSizes[stripe]);
+        }
+
+        for (const auto& metrics : stripeMetrics)
+        {
+            error_metrics_->merge(metrics, first_component);
+        }
+    }
+
+    // A stripe of consecutive restart intervals is encoded by one codec with the restart interval of the scan,
+    // the codec resets its coding state and writes the RSTm markers between the intervals of the stripe.
+    // The codec is kept in codec_cache: the stripe at the same position of a next image of the same size reuses it.
+    size_t encode_stripe(const ByteStreamInfo source, const uint32_t stride, const int32_t component_count,
+                         const size_t firstInterval, const size_t lastInterval, const ByteStreamInfo destination,
+                         error_metrics* metrics, JlsCodecCache<EncoderStrategy>& codec_cache) const
+    {
+        const size_t intervalCount = (frame_info_.height + restart_interval_ - 1) / restart_interval_;
+        const auto firstLine = static_cast<uint32_t>(firstInterval * restart_interval_);
+        const uint32_t height = static_cast<uint32_t>(std::min(lastInterval * restart_interval_, static_cast<size_t>(frame_info_.height))) - firstLine;
+        const charls::frame_info frame_info{frame_info_.width, height, frame_info_.bits_per_sample, component_count};
+        const coding_parameters parameters{near_lossless_, interleave_mode_, color_transformation_, false, restart_interval_};
+
+        EncoderStrategy& codec = codec_cache.GetCodec(frame_info, parameters, preset_coding_parameters_, allocator_);
+        codec.CollectErrorMetrics(metrics, 0);
+        codec.SetFirstRestartMarkerIndex(static_cast<int32_t>(firstInterval % JpegRestartMarkerRange));
+
+        ByteStreamInfo stripeSource{source};
+        SkipBytes(stripeSource, static_cast<size_t>(stride) * firstLine);
+        ByteStreamInfo stripeDestination{destination};
+        size_t bytesWritten = codec.EncodeScan(codec.CreateProcess(stripeSource, stride), stripeDestination);
+
+        // The last interval of the stripe is followed by a RSTm marker, unless it is the last interval of the scan.
+        if (lastInterval != intervalCount)
+        {
+            if (destination.count - bytesWritten < 2)
+                throw_jpegls_error(jpegls_errc::destination_buffer_too_small);
+
+            destination.rawData[bytesWritten++] = JpegMarkerStartByte;
+            destination.rawData[bytesWritten++] = static_cast<uint8_t>(static_cast<uint8_t>(JpegMarkerCode::RestartMarker0) + (lastInterval - 1) % JpegRestartMarkerRange);
+        }
+
+        return bytesWritten;
+    }
+
+    // More stripes than threads keep all threads busy when the stripes don't compress equally fast.
+    size_t maximum_stripe_count() const noexcept
+    {
+        return static_cast<size_t>(effective_thread_count(maximum_thread_count_)) * 4;
+    }
+
+    // Every component of a non-interleaved image is encoded in its own scan with its own context state.
+    // The first scan is encoded directly into the destination, the others into scratch buffers that are
+    // appended afterwards. The result is identical to encoding the scans one after another.
+    // The scans in the scratch buffers collect their error metrics separately, as they may be encoded twice.
+    void encode_scans_in_parallel(const ByteStreamInfo source, const uint32_t stride)
+    {
+        const size_t byteCountComponent = static_cast<size_t>(frame_info_.width) * frame_info_.height * ((frame_info_.bits_per_sample + 7) / 8);
+        const auto componentCount = static_cast<size_t>(frame_info_.component_count);
+
+        writer_.WriteStartOfScanSegment(1, near_lossless_, interleave_mode_);
+        const ByteStreamInfo destination{writer_.OutputStream()};
+
+        add_scratch_buffers(componentCount - 1);
+        add_parallel_codec_caches(componentCount);
+        vector<size_t> scanSizes(componentCount);
+        allocated_vector<error_metrics> scanMetrics{allocator_adapter<error_metrics>(allocator_)};
+        if (error_metrics_)
+        {
+            scanMetrics.resize(componentCount - 1, create_error_metrics(1));
+        }
+
+        parallel_for(componentCount, maximum_thread_count_, [&](const size_t component) {
+            ByteStreamInfo componentSource{source};
+            SkipBytes(componentSource, byteCountComponent * component);
+
+            if (component == 0)
+            {
+                scanSizes[component] = encode_scan(componentSource, stride, 1, 0, destination, error_metrics_.get(),
+                                                   parallel_codec_caches_[component]);
+                return;
+            }
+
+            // Start with a buffer that fits the typical case and retry with the remaining destination size if it is too small.
+            error_metrics* metrics = scanMetrics.empty() ? nullptr : &scanMetrics[component - 1];
+            size_t scanBufferSize = std::min(destination.count, byteCountComponent + 1024 + estimated_restart_markers_size() / componentCount);
+            for (;;)
+            {
+                try
+                {
+                    scanSizes[component] = encode_scan(componentSource, stride, 1, 0, scratch_buffer(component - 1, scanBufferSize),
+                                                       metrics, parallel_codec_caches_[component]);
+                    return;
+                }
+                catch (const jpegls_error& error)
+                {
+                    if (error.code() != jpegls_errc::destination_buffer_too_small || scanBufferSize == destination.count)
+                        throw;
+
+                    scanBufferSize = destination.count;
+                    if (metrics)
+                    {
+                        *metrics = create_error_metrics(1);
+                    }
+                }
+            }
+        });
+
+        writer_.Seek(scanSizes[0]);
+        for (size_t component = 1; component < componentCount; ++component)
+        {
+            writer_.WriteStartOfScanSegment(1, near_lossless_, interleave_mode_);
+            writer_.WriteBytes(scratch_buffers_[component - 1].data(), scanSizes[component]);
+        }
+
+        for (size_t component = 1; component <= scanMetrics.size(); ++component)
+        {
+            error_metrics_->merge(scanMetrics[component - 1], static_cast<int32_t>(component));
+        }
+    }
+
+    void add_scratch_buffers(const size_t count)
+    {
+        while (scratch_buffers_.size() < count)
+        {
+            scratch_buffers_.emplace_back(allocator_adapter<uint8_t>(allocator_));
+        }
+    }
+
+    // Every stripe or component scan of the multi-threaded code paths has its own codec cache, the threads never share a codec.
+    void add_parallel_codec_caches(const size_t count)
+    {
+        if (parallel_codec_caches_.size() < count)
+        {
+            parallel_codec_caches_.resize(count);
+        }
+    }
+
+    // The scratch buffers are kept for the next image: only growing a buffer fills the new part with zeros.
+    ByteStreamInfo scratch_buffer(const size_t index, const size_t size)
+    {
+        auto& buffer = scratch_buffers_[index];
+        if (buffer.size() < size)
+        {
+            buffer.resize(size);
+        }
+
+        return FromByteArray(buffer.data(), size);
+    }
+
+    error_metrics create_error_metrics(const int32_t component_count) const
+    {
+        const int32_t maximum_sample_value = preset_coding_parameters_.maximum_sample_value != 0
+                                                 ? preset_coding_parameters_.maximum_sample_value
+                                                 : calculate_maximum_sample_value(frame_info_.bits_per_sample);
+        return {component_count, near_lossless_, maximum_sample_value, allocator_};
+    }
+
+    const error_metrics& check_error_metrics(const int32_t component) const
+    {
+        if (!error_metrics_available_)
+            throw_jpegls_error(jpegls_errc::invalid_operation);
+
+        if (component < 0 || component >= error_metrics_->component_count())
+            throw_jpegls_error(jpegls_errc::invalid_argument);
+
+        return *error_metrics_;
+    }
+
+    size_t estimated_restart_markers_size() const noexcept
+    {
+        if (restart_interval_ == 0)
+            return 0;
+
+        // Every restart marker takes 2 bytes and the bit stream before it is padded to a byte boundary.
+        // The contexts are reset at the start of every interval: on noisy images the first samples coded in each of
+        // the 365 regular contexts can take up to twice their size.
+        constexpr size_t restart_marker_size{3};
+        constexpr size_t regular_context_count{365};
+        const size_t scan_count{interleave_mode_ == interleave_mode::none ? static_cast<size_t>(frame_info_.component_count) : 1};
+        const size_t interval_sample_count{static_cast<size_t>(restart_interval_) * frame_info_.width *
+                                           (static_cast<size_t>(frame_info_.component_count) / scan_count)};
+        const size_t context_reset_size{std::min(interval_sample_count, regular_context_count) * 2 *
+                                        (frame_info_.bits_per_sample < 9 ? 1 : 2)};
+        return (frame_info_.height / restart_interval_ + 1) * scan_count * (restart_marker_size + context_reset_size);
+    }
+
     charls_frame_info frame_info_{};
     int32_t near_lossless_{};
     charls::interleave_mode interleave_mode_{};
@@ -245,6 +620,18 @@ struct charls_jpegls_encoder final
     state state_{};
     JpegStreamWriter writer_;
     jpegls_pc_parameters preset_coding_parameters_{};
+    uint32_t maximum_thread_count_{1};
+    uint32_t restart_interval_{};
+    bool collect_error_metrics_{};
+    bool error_metrics_available_{};
+    using scratch_buffer_list = allocated_vector<allocated_vector<uint8_t>>;
+    using codec_cache_list = allocated_vector<JlsCodecCache<EncoderStrategy>>;
+
+    allocated_ptr<error_metrics> error_metrics_;
+    scratch_buffer_list scratch_buffers_;
+    charls_allocator allocator_{};
+    JlsCodecCache<EncoderStrategy> codec_cache_;
+    codec_cache_list parallel_codec_caches_;
 };
 
 extern "C" {
@@ -277,6 +664,18 @@ catch (...)
     return to_jpegls_errc();
 }
 
+jpegls_errc CHARLS_API_CALLING_CONVENTION
+charls_jpegls_encoder_reset(IN_ charls_jpegls_encoder* encoder) noexcept
+try
+{
+    check_pointer(encoder)->reset();
+    return jpegls_errc::success;
+}
+catch (...)
+{
+    return to_jpegls_errc();
+}
+
 jpegls_errc CHARLS_API_CALLING_CONVENTION
 charls_jpegls_encoder_set_frame_info(IN_ charls_jpegls_encoder* encoder,
                                      IN_ const charls_frame_info* frame_info) noexcept
@@ -342,6 +741,82 @@ catch (...)
     return to_jpegls_errc();
 }
 
+jpegls_errc CHARLS_API_CALLING_CONVENTION
+charls_jpegls_encoder_set_restart_interval(IN_ charls_jpegls_encoder* encoder,
+                                           const uint32_t restart_interval) noexcept
+try
+{
+    check_pointer(encoder)->restart_interval(restart_interval);
+    return jpegls_errc::success;
+}
+catch (...)
+{
+    return to_jpegls_errc();
+}
+
+jpegls_errc CHARLS_API_CALLING_CONVENTION
+charls_jpegls_encoder_set_maximum_thread_count(IN_ charls_jpegls_encoder* encoder,
+                                               const int32_t maximum_thread_count) noexcept
+try
+{
+    check_pointer(encoder)->maximum_thread_count(maximum_thread_count);
+    return jpegls_errc::success;
+}
+catch (...)
+{
+    return to_jpegls_errc();
+}
+
+jpegls_errc CHARLS_API_CALLING_CONVENTION
+charls_jpegls_encoder_set_allocator(IN_ charls_jpegls_encoder* encoder, IN_ const charls_allocator* allocator) noexcept
+try
+{
+    check_pointer(encoder)->allocator(*check_pointer(allocator));
+    return jpegls_errc::success;
+}
+catch (...)
+{
+    return to_jpegls_errc();
+}
+
+jpegls_errc CHARLS_API_CALLING_CONVENTION
+charls_jpegls_encoder_set_collect_error_metrics(IN_ charls_jpegls_encoder* encoder, const bool collect_error_metrics) noexcept
+try
+{
+    check_pointer(encoder)->collect_error_metrics(collect_error_metrics);
+    return jpegls_errc::success;
+}
+catch (...)
+{
+    return to_jpegls_errc();
+}
+
+jpegls_errc CHARLS_API_CALLING_CONVENTION
+charls_jpegls_encoder_get_component_error_metrics(IN_ const charls_jpegls_encoder* encoder, const int32_t component,
+                                                  OUT_ charls_component_error_metrics* error_metrics) noexcept
+try
+{
+    *check_pointer(error_metrics) = check_pointer(encoder)->component_error_metrics(component);
+    return jpegls_errc::success;
+}
+catch (...)
+{
+    return to_jpegls_errc();
+}
+
+jpegls_errc CHARLS_API_CALLING_CONVENTION
+charls_jpegls_encoder_get_error_histogram(IN_ const charls_jpegls_encoder* encoder, const int32_t component,
+                                          OUT_ uint64_t* histogram, const size_t histogram_size) noexcept
+try
+{
+    check_pointer(encoder)->error_histogram(component, check_pointer(histogram), histogram_size);
+    return jpegls_errc::success;
+}
+catch (...)
+{
+    return to_jpegls_errc();
+}
+
 jpegls_errc CHARLS_API_CALLING_CONVENTION
 charls_jpegls_encoder_get_estimated_destination_size(IN_ const charls_jpegls_encoder* encoder,
                                                      OUT_ size_t* size_in_bytes) noexcept
@@ -13,6 +13,7 @@ struct coding_parameters final
     charls::interleave_mode interleave_mode;
     color_transformation transformation;
     bool output_bgr;
+    uint32_t restart_interval;
 };
 
 } // namespace charls
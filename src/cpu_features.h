@@ -0,0 +1,51 @@
+// Copyright (c) Team CharLS.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+// Code that benefits from newer vector instructions can be compiled a second time for these instruction sets and
+// selected at runtime, one binary then runs at full speed on every CPU. This requires per function target attributes,
+// which are supported by GCC and Clang on x86. Other compilers and platforms always use the baseline code.
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define CHARLS_RUNTIME_DISPATCH
+
+// flatten inlines all called functions: they are compiled for the instruction set of the function as well.
+#define CHARLS_TARGET_SSE4_2 __attribute__((target("sse4.2"), flatten))
+#define CHARLS_TARGET_AVX2 __attribute__((target("avx2"), flatten))
+#else
+#define CHARLS_TARGET_SSE4_2
+#define CHARLS_TARGET_AVX2
+#endif
+
+namespace charls {
+
+// The instruction sets for which the library can contain specialized code, in increasing order.
+enum class instruction_set
+{
+    baseline, // The instruction set the library has been compiled for: SSE2 on x64, NEON on ARM64.
+    sse4_2,
+    avx2
+};
+
+
+// Purpose: returns the best instruction set supported by the CPU that the library can use.
+inline instruction_set detected_instruction_set() noexcept
+{
+#ifdef CHARLS_RUNTIME_DISPATCH
+    static const instruction_set detected{[]() noexcept {
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2"))
+            return instruction_set::avx2;
+
+        if (__builtin_cpu_supports("sse4.2"))
+            return instruction_set::sse4_2;
+
+        return instruction_set::baseline;
+    }()};
+    return detected;
+#else
+    return instruction_set::baseline;
+#endif
+}
+
+} // namespace charls
@@ -6,9 +6,12 @@
 #include <charls/jpegls_error.h>
 
 #include "jpeg_marker_code.h"
+#include "memory_allocator.h"
 #include "process_line.h"
+#include "simd.h"
 #include "util.h"
 
+#include <algorithm>
 #include <cassert>
 #include <memory>
 
@@ -18,9 +21,11 @@ namespace charls {
 class DecoderStrategy
 {
 public:
-    explicit DecoderStrategy(const frame_info& frame, const coding_parameters& parameters) :
+    DecoderStrategy(const frame_info& frame, const coding_parameters& parameters, const charls_allocator& memory_allocator) :
         frame_info_{frame},
-        parameters_{parameters}
+        parameters_{parameters},
+        allocator_{memory_allocator},
+        buffer_(allocator_adapter<uint8_t>(memory_allocator))
     {
     }
 
@@ -31,9 +36,15 @@ class DecoderStrategy
     DecoderStrategy& operator=(const DecoderStrategy&) = delete;
     DecoderStrategy& operator=(DecoderStrategy&&) = delete;
 
-    virtual std::unique_ptr<ProcessLine> CreateProcess(ByteStreamInfo rawStreamInfo, uint32_t stride) = 0;
+    virtual allocated_ptr<ProcessLine> CreateProcess(ByteStreamInfo rawStreamInfo, uint32_t stride) = 0;
     virtual void SetPresets(const jpegls_pc_parameters& preset_coding_parameters) = 0;
-    virtual void DecodeScan(std::unique_ptr<ProcessLine> outputData, const JlsRect& size, ByteStreamInfo& compressedData) = 0;
+    virtual void DecodeScan(allocated_ptr<ProcessLine> outputData, const JlsRect& size, ByteStreamInfo& compressedData) = 0;
+
+    // The restart intervals of a scan can be decoded in stripes: the first interval of a stripe is followed by RSTm marker m.
+    void SetFirstRestartMarkerIndex(const int32_t restartMarkerIndex) noexcept
+    {
+        firstRestartMarkerIndex_ = restartMarkerIndex;
+    }
 
     void Init(ByteStreamInfo& compressedStream)
     {
@@ -113,6 +124,33 @@ class DecoderStrategy
             impl::throw_jpegls_error(jpegls_errc::too_much_encoded_data);
     }
 
+    // Called at the end of a restart interval: the interval is terminated like a scan, followed by a RSTm marker.
+    void OnRestartMarker(const int32_t restartMarkerIndex)
+    {
+        EndScan();
+
+        AddBytesFromStream();
+        ++position_; // Skip the 0xFF byte, EndScan verified its presence.
+
+        // Optional 0xFF fill bytes may precede the marker code (see T.81, B.1.1.2)
+        while (position_ < endPosition_ && *position_ == JpegMarkerStartByte)
+        {
+            ++position_;
+        }
+
+        if (position_ == endPosition_ ||
+            *position_ != static_cast<uint8_t>(JpegMarkerCode::RestartMarker0) + restartMarkerIndex)
+            impl::throw_jpegls_error(jpegls_errc::restart_marker_not_found);
+
+        ++position_;
+
+        // The bit stream of the next interval starts at a byte boundary after the marker.
+        validBits_ = 0;
+        readCache_ = 0;
+        nextFFPosition_ = FindNextFF();
+        MakeValid();
+    }
+
     FORCE_INLINE bool OptimizedRead() noexcept
     {
         // Easy & fast: if there is no 0xFF byte in sight, we can read without bit stuffing
@@ -128,6 +166,53 @@ class DecoderStrategy
         return false;
     }
 
+    // Fills the cache from a window of sizeof(bufType) bytes that contains one or more 0xFF bytes.
+    // The stuffed 0 bits (the MSB of every byte that follows a 0xFF byte) are removed in bulk, which gives
+    // the same cache, position and bit count as the byte-by-byte loop in MakeValid.
+    // Returns false (and leaves the state unchanged) when the window is incomplete or may contain a marker.
+    FORCE_INLINE bool ReadWithStuffedBits() noexcept
+    {
+        constexpr auto window_size = static_cast<int32_t>(sizeof(bufType));
+        // A corrupt stream can leave a negative bit count (release builds only assert on it): leave it to the loop.
+        if (endPosition_ - position_ < window_size || validBits_ < 0)
+            return false;
+
+        const bufType window = FromBigEndian<sizeof(bufType)>::Read(position_);
+        const bufType ffBytes = ff_byte_high_bits(window);
+
+        // The loop consumes at least 1 byte and stops as soon as the cache holds bufType_bit_count - 8 bits.
+        // Every 0xFF byte adds only 7 bits, which can require 1 extra byte.
+        int32_t byteCount = std::max((bufType_bit_count - 1 - validBits_) >> 3, 1);
+        const int32_t validBitsWithoutFF = validBits_ + byteCount * 8;
+        byteCount += validBitsWithoutFF - high_bit_byte_count(ffBytes & leading_bits_mask(byteCount * 8)) < bufType_bit_count - 8;
+        if (byteCount > window_size)
+            return false;
+
+        // A 0xFF byte followed by a byte with the high bit set is a marker. A 0xFF byte at the end of the window
+        // cannot be checked: both cases are left to the loop.
+        const bufType consumedMask = leading_bits_mask(byteCount * 8);
+        const bufType consumedFFBytes = ffBytes & consumedMask;
+        if ((consumedFFBytes & ((window << 8) | 0x80)) != 0)
+            return false;
+
+        // Remove the stuffed bits, starting with the least significant so the positions of the others don't change.
+        bufType compacted = window;
+        int32_t rawBitCount = byteCount * 8;
+        for (bufType stuffedBits = (consumedFFBytes >> 8) & consumedMask; stuffedBits != 0; stuffedBits &= stuffedBits - 1)
+        {
+            const bufType lowBitsMask = (static_cast<bufType>(1) << countr_zero(stuffedBits)) - 1;
+            compacted = (compacted & ~(lowBitsMask << 1 | 1)) | ((compacted & lowBitsMask) << 1);
+            --rawBitCount;
+        }
+
+        // As in the loop, the last bit of a trailing 0xFF byte is stored in the cache but not counted as valid.
+        const bool lastByteIsFF = (consumedFFBytes & (static_cast<bufType>(0x80) << (bufType_bit_count - byteCount * 8))) != 0;
+        readCache_ |= (compacted & leading_bits_mask(rawBitCount)) >> validBits_;
+        validBits_ += rawBitCount - static_cast<int32_t>(lastByteIsFF);
+        position_ += byteCount;
+        return true;
+    }
+
     void MakeValid()
     {
         ASSERT(validBits_ <= bufType_bit_count - 8);
@@ -137,6 +222,12 @@ class DecoderStrategy
 
         AddBytesFromStream();
 
+        if (ReadWithStuffedBits())
+        {
+            nextFFPosition_ = FindNextFF();
+            return;
+        }
+
         do
         {
             if (position_ >= endPosition_)
@@ -176,17 +267,10 @@ class DecoderStrategy
 
     uint8_t* FindNextFF() const noexcept
     {
-        auto* positionNextFF = position_;
-
-        while (positionNextFF < endPosition_)
-        {
-            if (*positionNextFF == JpegMarkerStartByte)
-                break;
-
-            ++positionNextFF;
-        }
+        if (position_ >= endPosition_)
+            return position_;
 
-        return positionNextFF;
+        return position_ + (find_jpeg_marker_start_byte(position_, endPosition_) - position_);
     }
 
     uint8_t* GetCurBytePos() const noexcept
@@ -224,12 +308,20 @@ class DecoderStrategy
 
     FORCE_INLINE int32_t PeekByte()
     {
-        if (validBits_ < 8)
+        return PeekBits<8>();
+    }
+
+    template<int32_t BitCount>
+    FORCE_INLINE int32_t PeekBits()
+    {
+        static_assert(BitCount > 0 && BitCount <= 16, "BitCount must be in the range [1, 16]");
+
+        if (validBits_ < BitCount)
         {
             MakeValid();
         }
 
-        return static_cast<int32_t>(readCache_ >> (bufType_bit_count - 8));
+        return static_cast<int32_t>(readCache_ >> (bufType_bit_count - BitCount));
     }
 
     FORCE_INLINE bool ReadBit()
@@ -244,38 +336,53 @@ class DecoderStrategy
         return bSet;
     }
 
-    FORCE_INLINE int32_t Peek0Bits()
+    // Returns the number of consecutive 1 bits at the start of the bit cache, without consuming them.
+    FORCE_INLINE int32_t PeekLeadingOnes()
     {
         if (validBits_ < 16)
         {
             MakeValid();
         }
-        bufType valTest = readCache_;
 
-        for (int32_t count = 0; count < 16; ++count)
-        {
-            if ((valTest & (static_cast<bufType>(1) << (bufType_bit_count - 1))) != 0)
-                return count;
-
-            valTest <<= 1;
-        }
-        return -1;
+        return std::min(countl_zero(~readCache_), validBits_);
     }
 
     FORCE_INLINE int32_t ReadHighBits()
     {
-        const int32_t count = Peek0Bits();
-        if (count >= 0)
+        if (validBits_ < 16)
+        {
+            MakeValid();
+        }
+
+        // Fast path: the terminating 1 bit of the unary code is in the cache, the length is found with a single count leading zeros.
+        const int32_t count = countl_zero(readCache_);
+        if (count < validBits_)
         {
             Skip(count + 1);
             return count;
         }
-        Skip(15);
 
-        for (int32_t highBitsCount = 15;; ++highBitsCount)
+        return ReadHighBitsSlow();
+    }
+
+    // Handles unary codes that are longer than the bits in the cache (only possible with corrupt or extreme data).
+    int32_t ReadHighBitsSlow()
+    {
+        int32_t highBitsCount{};
+        for (;;)
         {
-            if (ReadBit())
-                return highBitsCount;
+            // All valid bits in the cache are 0: drop them and load the next bits.
+            highBitsCount += validBits_;
+            readCache_ = 0;
+            validBits_ = 0;
+            MakeValid();
+
+            const int32_t count = countl_zero(readCache_);
+            if (count < validBits_)
+            {
+                Skip(count + 1);
+                return highBitsCount + count;
+            }
         }
     }
 
@@ -290,13 +397,28 @@ class DecoderStrategy
 protected:
     frame_info frame_info_;
     coding_parameters parameters_;
-    std::unique_ptr<ProcessLine> processLine_;
+    charls_allocator allocator_;
+    allocated_ptr<ProcessLine> processLine_;
+    int32_t firstRestartMarkerIndex_{};
 
 private:
     using bufType = std::size_t;
     static constexpr auto bufType_bit_count = static_cast<int32_t>(sizeof(bufType) * 8);
+    static constexpr bufType low_byte_bits = ~static_cast<bufType>(0) / 0xFF; // 0x0101...01
+
+    // Mask with the bitCount most significant bits set, bitCount must be in the range [1, bufType_bit_count].
+    static constexpr bufType leading_bits_mask(const int32_t bitCount) noexcept
+    {
+        return ~static_cast<bufType>(0) << (bufType_bit_count - bitCount);
+    }
+
+    // Number of bytes that have their high bit set in a value with only high bits (0x80 per byte) set.
+    static constexpr int32_t high_bit_byte_count(const bufType highBits) noexcept
+    {
+        return static_cast<int32_t>(((highBits >> 7) * low_byte_bits) >> (bufType_bit_count - 8));
+    }
 
-    std::vector<uint8_t> buffer_;
+    allocated_vector<uint8_t> buffer_;
     std::basic_streambuf<char>* byteStream_{};
 
     // decoding
@@ -4,6 +4,7 @@
 #pragma once
 
 #include "decoder_strategy.h"
+#include "error_metrics.h"
 #include "process_line.h"
 
 namespace charls {
@@ -12,9 +13,11 @@ namespace charls {
 class EncoderStrategy
 {
 public:
-    explicit EncoderStrategy(const frame_info& frame, const coding_parameters& parameters) :
+    EncoderStrategy(const frame_info& frame, const coding_parameters& parameters, const charls_allocator& memory_allocator) :
         frame_info_{frame},
-        parameters_{parameters}
+        parameters_{parameters},
+        allocator_{memory_allocator},
+        buffer_(allocator_adapter<uint8_t>(memory_allocator))
     {
     }
 
@@ -25,12 +28,25 @@ class EncoderStrategy
     EncoderStrategy& operator=(const EncoderStrategy&) = delete;
     EncoderStrategy& operator=(EncoderStrategy&&) = delete;
 
-    virtual std::unique_ptr<ProcessLine> CreateProcess(ByteStreamInfo rawStreamInfo, uint32_t stride) = 0;
+    virtual allocated_ptr<ProcessLine> CreateProcess(ByteStreamInfo rawStreamInfo, uint32_t stride) = 0;
     virtual void SetPresets(const jpegls_pc_parameters& preset_coding_parameters) = 0;
-    virtual std::size_t EncodeScan(std::unique_ptr<ProcessLine> rawData, ByteStreamInfo& compressedData) = 0;
+    virtual std::size_t EncodeScan(allocated_ptr<ProcessLine> rawData, ByteStreamInfo& compressedData) = 0;
 
     int32_t PeekByte();
 
+    // Collects the error metrics of the encoded samples in metrics, the first component of the scan has index first_component.
+    void CollectErrorMetrics(error_metrics* metrics, const int32_t first_component) noexcept
+    {
+        errorMetrics_ = metrics;
+        firstComponent_ = first_component;
+    }
+
+    // The restart intervals of a scan can be encoded in stripes: the first interval of a stripe is followed by RSTm marker m.
+    void SetFirstRestartMarkerIndex(const int32_t restartMarkerIndex) noexcept
+    {
+        firstRestartMarkerIndex_ = restartMarkerIndex;
+    }
+
     void OnLineBegin(const int32_t cpixel, void* ptypeBuffer, const int32_t pixelStride) const
     {
         processLine_->NewLineRequested(ptypeBuffer, cpixel, pixelStride);
@@ -43,8 +59,10 @@ class EncoderStrategy
 protected:
     void Init(ByteStreamInfo& compressedStream)
     {
-        freeBitCount_ = sizeof(bitBuffer_) * 8;
+        freeBitCount_ = bit_buffer_bit_count;
         bitBuffer_ = 0;
+        isFFWritten_ = false;
+        bytesWritten_ = 0;
 
         if (compressedStream.rawStream)
         {
@@ -55,6 +73,7 @@ class EncoderStrategy
         }
         else
         {
+            compressedStream_ = nullptr;
             position_ = compressedStream.rawData;
             compressedLength_ = compressedStream.count;
         }
@@ -69,26 +88,24 @@ class EncoderStrategy
         ASSERT((static_cast<uint32_t>(bits) | mask) == mask); // Not used bits must be set to zero.
 #endif
 
+        // Shifting by the free bit count of an empty buffer (64) is undefined.
+        if (bitCount == 0)
+            return;
+
         freeBitCount_ -= bitCount;
         if (freeBitCount_ >= 0)
         {
-            bitBuffer_ |= bits << freeBitCount_; // NOLINT
+            bitBuffer_ |= static_cast<uint64_t>(bits) << freeBitCount_;
         }
         else
         {
             // Add as much bits in the remaining space as possible and flush.
-            bitBuffer_ |= bits >> -freeBitCount_;
+            // A flush frees at least 56 bits (8 bytes of which some may need an extra marker detect bit): enough for the rest.
+            bitBuffer_ |= static_cast<uint64_t>(bits) >> -freeBitCount_;
             Flush();
 
-            // A second flush may be required if extra marker detect bits were needed and not all bits could be written.
-            if (freeBitCount_ < 0)
-            {
-                bitBuffer_ |= bits >> -freeBitCount_;
-                Flush();
-            }
-
             ASSERT(freeBitCount_ >= 0);
-            bitBuffer_ |= bits << freeBitCount_;
+            bitBuffer_ |= static_cast<uint64_t>(bits) << freeBitCount_;
         }
     }
 
@@ -107,7 +124,7 @@ class EncoderStrategy
         }
 
         Flush();
-        ASSERT(freeBitCount_ == 0x20);
+        ASSERT(freeBitCount_ == bit_buffer_bit_count);
 
         if (compressedStream_)
         {
@@ -115,6 +132,24 @@ class EncoderStrategy
         }
     }
 
+    // Called at the end of a restart interval: the interval is terminated like a scan, followed by a RSTm marker.
+    void OnRestartMarker(const int32_t restartMarkerIndex)
+    {
+        EndScan();
+
+        if (compressedLength_ < 2)
+        {
+            OverFlow();
+        }
+
+        *position_ = JpegMarkerStartByte;
+        position_[1] = static_cast<uint8_t>(static_cast<uint8_t>(JpegMarkerCode::RestartMarker0) + restartMarkerIndex);
+        position_ += 2;
+        compressedLength_ -= 2;
+        bytesWritten_ += 2;
+        isFFWritten_ = false;
+    }
+
     void OverFlow()
     {
         if (!compressedStream_)
@@ -132,26 +167,38 @@ class EncoderStrategy
 
     void Flush()
     {
-        if (compressedLength_ < 4)
+        // Fast path: a full bit buffer without a 0xFF byte needs no marker detect bits and is written with a single store.
+        if (freeBitCount_ <= 0 && !isFFWritten_ && compressedLength_ >= sizeof(bitBuffer_) && !has_ff_byte(bitBuffer_))
         {
-            OverFlow();
+            WriteBigEndian(position_, bitBuffer_);
+            bitBuffer_ = 0;
+            freeBitCount_ += bit_buffer_bit_count;
+            position_ += sizeof(bitBuffer_);
+            compressedLength_ -= sizeof(bitBuffer_);
+            bytesWritten_ += sizeof(bitBuffer_);
+            return;
         }
 
-        for (int i = 0; i < 4; ++i)
+        for (std::size_t i = 0; i < sizeof(bitBuffer_); ++i)
         {
-            if (freeBitCount_ >= 32)
+            if (freeBitCount_ >= bit_buffer_bit_count)
                 break;
 
+            if (compressedLength_ == 0)
+            {
+                OverFlow();
+            }
+
             if (isFFWritten_)
             {
                 // JPEG-LS requirement (T.87, A.1) to detect markers: after a xFF value a single 0 bit needs to be inserted.
-                *position_ = static_cast<uint8_t>(bitBuffer_ >> 25);
+                *position_ = static_cast<uint8_t>(bitBuffer_ >> (bit_buffer_bit_count - 7));
                 bitBuffer_ = bitBuffer_ << 7;
                 freeBitCount_ += 7;
             }
             else
             {
-                *position_ = static_cast<uint8_t>(bitBuffer_ >> 24);
+                *position_ = static_cast<uint8_t>(bitBuffer_ >> (bit_buffer_bit_count - 8));
                 bitBuffer_ = bitBuffer_ << 8;
                 freeBitCount_ += 8;
             }
@@ -165,7 +212,7 @@ class EncoderStrategy
 
     std::size_t GetLength() const noexcept
     {
-        return bytesWritten_ - (freeBitCount_ - 32) / 8;
+        return bytesWritten_ - (freeBitCount_ - bit_buffer_bit_count) / 8;
     }
 
     FORCE_INLINE void AppendOnesToBitStream(const int32_t length)
@@ -175,12 +222,18 @@ class EncoderStrategy
 
     frame_info frame_info_;
     coding_parameters parameters_;
+    charls_allocator allocator_;
     std::unique_ptr<DecoderStrategy> decoder_;
-    std::unique_ptr<ProcessLine> processLine_;
+    allocated_ptr<ProcessLine> processLine_;
+    error_metrics* errorMetrics_{};
+    int32_t firstComponent_{};
+    int32_t firstRestartMarkerIndex_{};
 
 private:
-    unsigned int bitBuffer_{};
-    int32_t freeBitCount_{sizeof bitBuffer_ * 8};
+    static constexpr int32_t bit_buffer_bit_count = 64;
+
+    uint64_t bitBuffer_{};
+    int32_t freeBitCount_{bit_buffer_bit_count};
     std::size_t compressedLength_{};
 
     // encoding
@@ -188,7 +241,7 @@ class EncoderStrategy
     bool isFFWritten_{};
     std::size_t bytesWritten_{};
 
-    std::vector<uint8_t> buffer_;
+    allocated_vector<uint8_t> buffer_;
     std::basic_streambuf<char>* compressedStream_{};
 };
 
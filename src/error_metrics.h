@@ -0,0 +1,151 @@
+// Copyright (c) Team CharLS.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#include "memory_allocator.h"
+#include "util.h"
+
+#include <charls/public_types.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace charls {
+
+// Purpose: collects the differences between the source samples and the samples reconstructed by a near-lossless encoder.
+//          Every component has a histogram of the error values (range [-NEAR, NEAR]), all other metrics are derived from it.
+//          Sign convention: error value = source - reconstructed, index 0 of a histogram is error value -NEAR
+//          (the reconstructed sample is NEAR larger than the source sample).
+class error_metrics final
+{
+public:
+    error_metrics(const int32_t component_count, const int32_t near_lossless, const int32_t maximum_sample_value,
+                  const charls_allocator& memory_allocator = {}) :
+        near_lossless_{near_lossless},
+        maximum_sample_value_{maximum_sample_value},
+        histograms_(static_cast<size_t>(component_count) * static_cast<size_t>(2 * near_lossless + 1), allocator_adapter<uint64_t>(memory_allocator))
+    {
+    }
+
+    int32_t component_count() const noexcept
+    {
+        return static_cast<int32_t>(histograms_.size() / histogram_size());
+    }
+
+    void add_line(const int32_t component, const uint8_t* source, const uint8_t* reconstructed, const uint32_t width) noexcept
+    {
+        add_samples(component, source, reconstructed, width);
+    }
+
+    void add_line(const int32_t component, const uint16_t* source, const uint16_t* reconstructed, const uint32_t width) noexcept
+    {
+        add_samples(component, source, reconstructed, width);
+    }
+
+    template<typename Sample>
+    void add_line(const int32_t component, const Triplet<Sample>* source, const Triplet<Sample>* reconstructed, const uint32_t width) noexcept
+    {
+        for (uint32_t i = 0; i < width; ++i)
+        {
+            add(component, source[i].v1, reconstructed[i].v1);
+            add(component + 1, source[i].v2, reconstructed[i].v2);
+            add(component + 2, source[i].v3, reconstructed[i].v3);
+        }
+    }
+
+    template<typename Sample>
+    void add_line(const int32_t component, const Quad<Sample>* source, const Quad<Sample>* reconstructed, const uint32_t width) noexcept
+    {
+        for (uint32_t i = 0; i < width; ++i)
+        {
+            add(component, source[i].v1, reconstructed[i].v1);
+            add(component + 1, source[i].v2, reconstructed[i].v2);
+            add(component + 2, source[i].v3, reconstructed[i].v3);
+            add(component + 3, source[i].v4, reconstructed[i].v4);
+        }
+    }
+
+    // Adds the metrics collected by other (for example by the encoder of another scan or restart interval).
+    void merge(const error_metrics& other, const int32_t first_component) noexcept
+    {
+        ASSERT(other.near_lossless_ == near_lossless_);
+
+        const size_t offset = static_cast<size_t>(first_component) * histogram_size();
+        ASSERT(offset + other.histograms_.size() <= histograms_.size());
+        for (size_t i = 0; i < other.histograms_.size(); ++i)
+        {
+            histograms_[offset + i] += other.histograms_[i];
+        }
+    }
+
+    charls_component_error_metrics get_component_metrics(const int32_t component) const noexcept
+    {
+        charls_component_error_metrics metrics{};
+        metrics.near_lossless = near_lossless_;
+
+        const uint64_t* histogram = component_histogram(component);
+        for (int32_t error_value = -near_lossless_; error_value <= near_lossless_; ++error_value)
+        {
+            const uint64_t count = histogram[error_value + near_lossless_];
+            if (count == 0)
+                continue;
+
+            metrics.sample_count += count;
+            metrics.sum_squared_error += count * static_cast<uint64_t>(error_value * error_value);
+            metrics.maximum_error = std::max(metrics.maximum_error, std::abs(error_value));
+        }
+
+        // Without samples the mean squared error is 0 / 0, there is no error either.
+        if (metrics.sample_count == 0 || metrics.sum_squared_error == 0)
+        {
+            metrics.peak_signal_to_noise_ratio = std::numeric_limits<double>::infinity();
+        }
+        else
+        {
+            const double mean_squared_error = static_cast<double>(metrics.sum_squared_error) / static_cast<double>(metrics.sample_count);
+            const double maximum_sample_value = maximum_sample_value_;
+            metrics.peak_signal_to_noise_ratio = 10.0 * std::log10(maximum_sample_value * maximum_sample_value / mean_squared_error);
+        }
+
+        return metrics;
+    }
+
+    size_t histogram_size() const noexcept
+    {
+        return static_cast<size_t>(2 * near_lossless_ + 1);
+    }
+
+    // Returns the number of samples for each error value (source - reconstructed), index 0 is error value -NEAR.
+    const uint64_t* component_histogram(const int32_t component) const noexcept
+    {
+        return &histograms_[static_cast<size_t>(component) * histogram_size()];
+    }
+
+private:
+    template<typename Sample>
+    void add_samples(const int32_t component, const Sample* source, const Sample* reconstructed, const uint32_t width) noexcept
+    {
+        for (uint32_t i = 0; i < width; ++i)
+        {
+            add(component, source[i], reconstructed[i]);
+        }
+    }
+
+    // Note: source samples larger than MAXVAL are invalid input, their error is counted at the edge of the histogram.
+    FORCE_INLINE void add(const int32_t component, const int32_t source, const int32_t reconstructed) noexcept
+    {
+        const int32_t error_value = std::min(std::max(source - reconstructed, -near_lossless_), near_lossless_);
+        ++histograms_[static_cast<size_t>(component) * histogram_size() + near_lossless_ + error_value];
+    }
+
+    int32_t near_lossless_;
+    int32_t maximum_sample_value_;
+    allocated_vector<uint64_t> histograms_;
+};
+
+} // namespace charls
@@ -47,7 +47,7 @@ void VerifyInput(const ByteStreamInfo& destination, const JlsParameters& paramet
 void EncodeScan(const JlsParameters& params, const int componentCount, const ByteStreamInfo source, JpegStreamWriter& writer)
 {
     const frame_info frame_info{static_cast<uint32_t>(params.width), static_cast<uint32_t>(params.height), params.bitsPerSample, componentCount};
-    const coding_parameters codec_parameters{params.allowedLossyError, params.interleaveMode, params.colorTransformation, false};
+    const coding_parameters codec_parameters{params.allowedLossyError, params.interleaveMode, params.colorTransformation, false, 0};
     const jpegls_pc_parameters preset_coding_parameters{
         params.custom.MaximumSampleValue,
         params.custom.Threshold1,
@@ -57,7 +57,7 @@ void EncodeScan(const JlsParameters& params, const int componentCount, const Byt
     };
 
     auto codec = JlsCodecFactory<EncoderStrategy>().CreateCodec(frame_info, codec_parameters, preset_coding_parameters);
-    std::unique_ptr<ProcessLine> processLine(codec->CreateProcess(source, params.stride));
+    allocated_ptr<ProcessLine> processLine(codec->CreateProcess(source, params.stride));
     ByteStreamInfo destination{writer.OutputStream()};
     const size_t bytesWritten = codec->EncodeScan(move(processLine), destination);
 
@@ -4,8 +4,7 @@
 #pragma once
 
 #include "coding_parameters.h"
-
-#include <memory>
+#include "memory_allocator.h"
 
 
 namespace charls {
@@ -17,13 +16,47 @@ template<typename Strategy>
 class JlsCodecFactory final
 {
 public:
-    std::unique_ptr<Strategy> CreateCodec(const frame_info& frame, const coding_parameters& parameters, const jpegls_pc_parameters& preset_coding_parameters);
+    JlsCodecFactory() = default;
+
+    // The codec and its buffers are allocated with memory_allocator.
+    explicit JlsCodecFactory(const charls_allocator& memory_allocator) noexcept :
+        allocator_{memory_allocator}
+    {
+    }
+
+    allocated_ptr<Strategy> CreateCodec(const frame_info& frame, const coding_parameters& parameters, const jpegls_pc_parameters& preset_coding_parameters);
 
 private:
-    std::unique_ptr<Strategy> CreateOptimizedCodec(const frame_info& frame, const coding_parameters& parameters);
+    allocated_ptr<Strategy> CreateOptimizedCodec(const frame_info& frame, const coding_parameters& parameters);
+
+    charls_allocator allocator_{};
 };
 
 extern template class JlsCodecFactory<DecoderStrategy>;
 extern template class JlsCodecFactory<EncoderStrategy>;
 
+
+// Purpose: keeps the codec of the last scan of an encoder or decoder. A next scan with the same frame info, coding
+//          parameters and allocator reuses it, with its lookup tables and line buffers, instead of allocating a new codec.
+template<typename Strategy>
+class JlsCodecCache final
+{
+public:
+    Strategy& GetCodec(const frame_info& frame, const coding_parameters& parameters, const jpegls_pc_parameters& preset_coding_parameters,
+                       const charls_allocator& memory_allocator);
+
+    // Releases the codec, with the allocator it was created with.
+    void Clear() noexcept;
+
+private:
+    allocated_ptr<Strategy> codec_;
+    charls_allocator allocator_{};
+    frame_info frame_{};
+    coding_parameters parameters_{};
+    jpegls_pc_parameters preset_coding_parameters_{};
+};
+
+extern template class JlsCodecCache<DecoderStrategy>;
+extern template class JlsCodecCache<EncoderStrategy>;
+
 } // namespace charls
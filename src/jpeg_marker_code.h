@@ -16,6 +16,7 @@ namespace charls {
 // 0x4F - 0x6F, 0x90 - 0x93 are defined in ISO/IEC 15444-1: JPEG 2000
 
 constexpr uint8_t JpegMarkerStartByte = 0xFF;
+constexpr int32_t JpegRestartMarkerRange = 8; // The restart markers RST0 - RST7 are used in a cycle.
 
 enum class JpegMarkerCode : uint8_t
 {
@@ -23,6 +24,16 @@ enum class JpegMarkerCode : uint8_t
     EndOfImage = 0xD9,   // EOI: Marks the end of an image.
     StartOfScan = 0xDA,  // SOS: Marks the start of scan.
 
+    DefineRestartInterval = 0xDD, // DRI: Defines the number of MCUs (lines in JPEG-LS) between restart markers.
+    RestartMarker0 = 0xD0,        // RST0: Marks the end of the 1st, 9th, ... restart interval.
+    RestartMarker1 = 0xD1,        // RST1
+    RestartMarker2 = 0xD2,        // RST2
+    RestartMarker3 = 0xD3,        // RST3
+    RestartMarker4 = 0xD4,        // RST4
+    RestartMarker5 = 0xD5,        // RST5
+    RestartMarker6 = 0xD6,        // RST6
+    RestartMarker7 = 0xD7,        // RST7
+
     // The following markers are defined in ISO/IEC 10918-1 | ITU T.81.
     StartOfFrameBaselineJpeg = 0xC0,            // SOF_0:  Marks the start of a baseline jpeg encoded frame.
     StartOfFrameExtendedSequential = 0xC1,      // SOF_1:  Marks the start of a extended sequential Huffman encoded frame.
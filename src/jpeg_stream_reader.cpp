@@ -9,25 +9,64 @@
 #include "jls_codec_factory.h"
 #include "jpeg_marker_code.h"
 #include "jpegls_preset_parameters_type.h"
+#include "parallel_for.h"
+#include "pipelined_process_line.h"
 #include "util.h"
 
 #include <algorithm>
+#include <array>
 #include <iomanip>
 #include <memory>
 
+using std::array;
 using std::find;
-using std::unique_ptr;
 using std::vector;
 using charls::impl::throw_jpegls_error;
 
 namespace charls {
 
+namespace {
+
+constexpr bool is_restart_marker_code(const uint8_t markerCode) noexcept
+{
+    return markerCode >= static_cast<uint8_t>(JpegMarkerCode::RestartMarker0) &&
+           markerCode <= static_cast<uint8_t>(JpegMarkerCode::RestartMarker7);
+}
+
+} // namespace
+
 JpegStreamReader::JpegStreamReader(ByteStreamInfo byteStreamInfo) noexcept :
     byteStream_{byteStreamInfo}
 {
 }
 
 
+JpegStreamReader::~JpegStreamReader() = default;
+
+
+void JpegStreamReader::Reset(const ByteStreamInfo byteStreamInfo) noexcept
+{
+    byteStream_ = byteStreamInfo;
+    frame_info_ = {};
+    parameters_ = {};
+    preset_coding_parameters_ = {};
+    rect_ = {};
+    componentIds_.clear();
+    maximum_thread_count_ = 1;
+    state_ = {};
+}
+
+
+void JpegStreamReader::SetAllocator(const charls_allocator& memory_allocator) noexcept
+{
+    if (memory_allocator != allocator_)
+    {
+        codecCache_.Clear();
+        allocator_ = memory_allocator;
+    }
+}
+
+
 void JpegStreamReader::Read(ByteStreamInfo rawPixels, uint32_t stride)
 {
     ASSERT(state_ == state::bit_stream_section);
@@ -52,6 +91,9 @@ void JpegStreamReader::Read(ByteStreamInfo rawPixels, uint32_t stride)
     if (rawPixels.rawData && static_cast<int64_t>(rawPixels.count) < bytesPerPlane * frame_info_.component_count)
         throw_jpegls_error(jpegls_errc::destination_buffer_too_small);
 
+    if (CanReadScansInParallel(rawPixels, stride, bytesPerPlane) && TryReadScansInParallel(rawPixels, stride, bytesPerPlane))
+        return;
+
     int componentIndex{};
     while (componentIndex < frame_info_.component_count)
     {
@@ -60,9 +102,11 @@ void JpegStreamReader::Read(ByteStreamInfo rawPixels, uint32_t stride)
             ReadNextStartOfScan();
         }
 
-        unique_ptr<DecoderStrategy> codec = JlsCodecFactory<DecoderStrategy>().CreateCodec(frame_info_, parameters_, preset_coding_parameters_);
-        unique_ptr<ProcessLine> processLine(codec->CreateProcess(rawPixels, stride));
-        codec->DecodeScan(move(processLine), rect_, byteStream_);
+        if (!CanReadRestartIntervalsInParallel(rawPixels, stride) || !TryReadRestartIntervalsInParallel(rawPixels, stride))
+        {
+            ReadScan(rawPixels, stride);
+        }
+
         SkipBytes(rawPixels, static_cast<size_t>(bytesPerPlane));
         state_ = state::scan_section;
 
@@ -74,11 +118,256 @@ void JpegStreamReader::Read(ByteStreamInfo rawPixels, uint32_t stride)
 }
 
 
-void JpegStreamReader::ReadNBytes(std::vector<char>& destination, const int byteCount)
+void JpegStreamReader::ReadScan(const ByteStreamInfo rawPixels, const uint32_t stride)
+{
+    DecoderStrategy& codec = codecCache_.GetCodec(frame_info_, parameters_, preset_coding_parameters_, allocator_);
+    allocated_ptr<ProcessLine> processLine(codec.CreateProcess(rawPixels, stride));
+    if (!CanPipelineLineOutput())
+    {
+        codec.DecodeScan(move(processLine), rect_, byteStream_);
+        return;
+    }
+
+    // The codec owns the pipeline, it remains valid until the codec is destroyed or decodes the next scan.
+    auto pipeline = allocate_unique<PipelinedProcessLine>(allocator_, move(processLine), frame_info_, parameters_, allocator_);
+    PipelinedProcessLine& pipelineReference = *pipeline;
+    try
+    {
+        codec.DecodeScan(move(pipeline), rect_, byteStream_);
+    }
+    catch (...)
+    {
+        // The helper thread may not write to the destination after the decoder has failed.
+        pipelineReference.Stop();
+        throw;
+    }
+    pipelineReference.Flush();
+}
+
+
+bool JpegStreamReader::CanPipelineLineOutput() const noexcept
+{
+    // Only the output of interleaved multi-component lines (color transform, pixel interleaving) is worth a helper thread.
+    return parameters_.interleave_mode != interleave_mode::none && frame_info_.component_count > 1 &&
+           effective_thread_count(maximum_thread_count_) > 1;
+}
+
+
+bool JpegStreamReader::CanReadScansInParallel(const ByteStreamInfo rawPixels, const uint32_t stride, const int64_t bytesPerPlane) const noexcept
+{
+    if (parameters_.interleave_mode != interleave_mode::none || frame_info_.component_count < 2 ||
+        effective_thread_count(maximum_thread_count_) < 2)
+        return false;
+
+    // Streams can only be accessed sequentially.
+    if (!byteStream_.rawData || !rawPixels.rawData)
+        return false;
+
+    // Every scan must write only to its own plane, otherwise the decoded scans would overwrite each other.
+    const int64_t bytesPerLine = static_cast<int64_t>(rect_.Width) * ((frame_info_.bits_per_sample + 7) / 8);
+    return static_cast<int64_t>(stride) * (rect_.Height - 1) + bytesPerLine <= bytesPerPlane;
+}
+
+
+bool JpegStreamReader::TryReadScansInParallel(const ByteStreamInfo rawPixels, const uint32_t stride, const int64_t bytesPerPlane)
+{
+    vector<scan_info> scans;
+    if (!FindStartOfScans(scans))
+        return false;
+
+    // Every scan of a non-interleaved image has its own context state and can be decoded independently.
+    parallel_for(scans.size(), maximum_thread_count_, [&](const size_t scanIndex) {
+        auto codec = JlsCodecFactory<DecoderStrategy>(allocator_).CreateCodec(frame_info_, scans[scanIndex].parameters, scans[scanIndex].preset_coding_parameters);
+
+        ByteStreamInfo destination{rawPixels};
+        SkipBytes(destination, static_cast<size_t>(bytesPerPlane) * scanIndex);
+        allocated_ptr<ProcessLine> processLine(codec->CreateProcess(destination, stride));
+        codec->DecodeScan(move(processLine), rect_, scans[scanIndex].source);
+    });
+
+    byteStream_ = scans.back().source;
+    state_ = state::scan_section;
+    return true;
+}
+
+
+bool JpegStreamReader::CanReadRestartIntervalsInParallel(const ByteStreamInfo rawPixels, const uint32_t stride) const noexcept
+{
+    if (parameters_.restart_interval == 0 || parameters_.restart_interval >= frame_info_.height ||
+        effective_thread_count(maximum_thread_count_) < 2)
+        return false;
+
+    // Streams can only be accessed sequentially.
+    if (!byteStream_.rawData || !rawPixels.rawData)
+        return false;
+
+    // Every restart interval is decoded into its own band of lines, this requires that all lines are decoded.
+    if (rect_.X != 0 || rect_.Y != 0 || rect_.Width != static_cast<int32_t>(frame_info_.width) ||
+        rect_.Height != static_cast<int32_t>(frame_info_.height))
+        return false;
+
+    const uint32_t components = parameters_.interleave_mode == interleave_mode::none ? 1 : frame_info_.component_count;
+    return stride >= components * frame_info_.width * ((frame_info_.bits_per_sample + 7) / 8);
+}
+
+
+bool JpegStreamReader::TryReadRestartIntervalsInParallel(const ByteStreamInfo rawPixels, const uint32_t stride)
+{
+    vector<ByteStreamInfo> intervals;
+    if (!FindRestartIntervals(intervals))
+        return false;
+
+    // The coding state is reset at every restart marker: the intervals are decoded in horizontal stripes of consecutive intervals,
+    // every stripe as a separate image with the restart interval of the scan. More stripes than threads keep all threads
+    // busy when the stripes don't decode equally fast.
+    const uint32_t restartInterval = parameters_.restart_interval;
+    const size_t maximumStripeCount = static_cast<size_t>(effective_thread_count(maximum_thread_count_)) * 4;
+    const size_t intervalsPerStripe = (intervals.size() + maximumStripeCount - 1) / maximumStripeCount;
+    const size_t stripeCount = (intervals.size() + intervalsPerStripe - 1) / intervalsPerStripe;
+
+    ByteStreamInfo endOfScan{};
+    parallel_for(stripeCount, maximum_thread_count_, [&](const size_t stripe) {
+        const size_t firstInterval = stripe * intervalsPerStripe;
+        const size_t lastInterval = std::min(intervals.size(), firstInterval + intervalsPerStripe);
+        const auto firstLine = static_cast<uint32_t>(firstInterval * restartInterval);
+        charls::frame_info frameInfo{frame_info_};
+        frameInfo.height = std::min(static_cast<uint32_t>(lastInterval * restartInterval), frame_info_.height) - firstLine;
+
+        auto codec = JlsCodecFactory<DecoderStrategy>(allocator_).CreateCodec(frameInfo, parameters_, preset_coding_parameters_);
+        codec->SetFirstRestartMarkerIndex(static_cast<int32_t>(firstInterval % JpegRestartMarkerRange));
+
+        // The bit streams of the intervals are consecutive, the stripe includes the RSTm markers between them.
+        ByteStreamInfo source{intervals[firstInterval]};
+        source.count = static_cast<size_t>(intervals[lastInterval - 1].rawData + intervals[lastInterval - 1].count - source.rawData);
+
+        ByteStreamInfo destination{rawPixels};
+        SkipBytes(destination, static_cast<size_t>(stride) * firstLine);
+        allocated_ptr<ProcessLine> processLine(codec->CreateProcess(destination, stride));
+        codec->DecodeScan(move(processLine), {0, 0, static_cast<int32_t>(frameInfo.width), static_cast<int32_t>(frameInfo.height)}, source);
+
+        if (lastInterval == intervals.size())
+        {
+            endOfScan = source;
+        }
+    });
+
+    byteStream_ = endOfScan;
+    return true;
+}
+
+
+// Purpose: locates the bit stream of every restart interval of the current scan by searching for the RSTm markers.
+//          Every interval (except the last) includes its terminating marker, the decoder expects a marker at the end of the bit stream.
+bool JpegStreamReader::FindRestartIntervals(vector<ByteStreamInfo>& intervals) const
+{
+    const uint32_t restartInterval = parameters_.restart_interval;
+    const size_t intervalCount = (frame_info_.height + restartInterval - 1) / restartInterval;
+    intervals.reserve(intervalCount);
+
+    const uint8_t* const end = byteStream_.rawData + byteStream_.count;
+    ByteStreamInfo interval{byteStream_};
+    for (const uint8_t* position = find(static_cast<const uint8_t*>(interval.rawData), end, JpegMarkerStartByte);
+         position < end - 1 && intervals.size() + 1 < intervalCount;
+         position = find(position + 1, end, JpegMarkerStartByte))
+    {
+        // Optional 0xFF fill bytes may precede the marker code.
+        const uint8_t* markerCode = position + 1;
+        while (markerCode < end && *markerCode == JpegMarkerStartByte)
+        {
+            ++markerCode;
+        }
+
+        if (markerCode == end)
+            return false;
+
+        if (*markerCode < 0x80)
+            continue;
+
+        if (*markerCode != static_cast<uint8_t>(JpegMarkerCode::RestartMarker0) + intervals.size() % JpegRestartMarkerRange)
+            return false;
+
+        interval.count = static_cast<size_t>(markerCode + 1 - interval.rawData);
+        intervals.push_back(interval);
+
+        interval.rawData += interval.count;
+        interval.count = static_cast<size_t>(end - interval.rawData);
+        position = markerCode;
+    }
+
+    if (intervals.size() + 1 != intervalCount)
+        return false;
+
+    intervals.push_back(interval);
+    return true;
+}
+
+
+// Purpose: locates the bit stream of every scan by walking the marker segments between the scans.
+//          The reader state is restored when the scans cannot be located, the sequential decoder will then report the problem.
+bool JpegStreamReader::FindStartOfScans(vector<scan_info>& scans)
+{
+    const ByteStreamInfo byteStream{byteStream_};
+    const coding_parameters parameters{parameters_};
+    const jpegls_pc_parameters presetCodingParameters{preset_coding_parameters_};
+
+    scans.reserve(frame_info_.component_count);
+    scans.push_back({byteStream_, parameters_, preset_coding_parameters_});
+
+    try
+    {
+        while (scans.size() < static_cast<size_t>(frame_info_.component_count) && SkipToEndOfScan())
+        {
+            state_ = state::scan_section;
+            ReadNextStartOfScan();
+            if (parameters_.interleave_mode != interleave_mode::none)
+                break;
+
+            scans.push_back({byteStream_, parameters_, preset_coding_parameters_});
+        }
+    }
+    catch (const jpegls_error&)
+    {
+        scans.clear();
+    }
+
+    if (scans.size() == static_cast<size_t>(frame_info_.component_count))
+        return true;
+
+    byteStream_ = byteStream;
+    parameters_ = parameters;
+    preset_coding_parameters_ = presetCodingParameters;
+    state_ = state::bit_stream_section;
+    return false;
+}
+
+
+bool JpegStreamReader::SkipToEndOfScan() noexcept
+{
+    // A marker is a 0xFF byte followed by a byte with the high bit set, bit stuffing guarantees that
+    // a 0xFF byte in the bit stream is always followed by a byte with the high bit cleared.
+    // Restart markers are part of the scan and are skipped.
+    const uint8_t* const begin = byteStream_.rawData;
+    const uint8_t* const end = begin + byteStream_.count;
+    for (const uint8_t* position = find(begin, end, JpegMarkerStartByte);
+         position < end - 1;
+         position = find(position + 1, end, JpegMarkerStartByte))
+    {
+        if (position[1] >= 0x80 && !is_restart_marker_code(position[1]))
+        {
+            SkipBytes(byteStream_, static_cast<size_t>(position - begin));
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+void JpegStreamReader::ReadNBytes(char* destination, const int byteCount)
 {
     for (int i = 0; i < byteCount; ++i)
     {
-        destination.push_back(static_cast<char>(ReadByte()));
+        destination[i] = static_cast<char>(ReadByte());
     }
 }
 
@@ -206,6 +495,7 @@ void JpegStreamReader::ValidateMarkerCode(const JpegMarkerCode markerCode) const
         return;
 
     case JpegMarkerCode::JpegLSPresetParameters:
+    case JpegMarkerCode::DefineRestartInterval:
     case JpegMarkerCode::Comment:
     case JpegMarkerCode::ApplicationData0:
     case JpegMarkerCode::ApplicationData1:
@@ -244,6 +534,17 @@ void JpegStreamReader::ValidateMarkerCode(const JpegMarkerCode markerCode) const
 
     case JpegMarkerCode::EndOfImage:
         throw_jpegls_error(jpegls_errc::unexpected_end_of_image_marker);
+
+    // Restart markers are only valid inside the bit stream of a scan.
+    case JpegMarkerCode::RestartMarker0:
+    case JpegMarkerCode::RestartMarker1:
+    case JpegMarkerCode::RestartMarker2:
+    case JpegMarkerCode::RestartMarker3:
+    case JpegMarkerCode::RestartMarker4:
+    case JpegMarkerCode::RestartMarker5:
+    case JpegMarkerCode::RestartMarker6:
+    case JpegMarkerCode::RestartMarker7:
+        throw_jpegls_error(jpegls_errc::unexpected_marker_found);
     }
 
     throw_jpegls_error(jpegls_errc::unknown_jpeg_marker_found);
@@ -266,6 +567,9 @@ int JpegStreamReader::ReadMarkerSegment(const JpegMarkerCode markerCode,
     case JpegMarkerCode::JpegLSPresetParameters:
         return ReadPresetParametersSegment(segmentSize);
 
+    case JpegMarkerCode::DefineRestartInterval:
+        return ReadDefineRestartIntervalSegment(segmentSize);
+
     case JpegMarkerCode::ApplicationData0:
     case JpegMarkerCode::ApplicationData1:
     case JpegMarkerCode::ApplicationData2:
@@ -286,7 +590,7 @@ int JpegStreamReader::ReadMarkerSegment(const JpegMarkerCode markerCode,
     case JpegMarkerCode::ApplicationData8:
         return TryReadApplicationData8Segment(segmentSize, header, spiff_header_found);
 
-    // Other tags not supported (among which DNL DRI)
+    // Other tags not supported (among which DNL)
     default:
         ASSERT(false);
         return 0;
@@ -404,6 +708,32 @@ int JpegStreamReader::ReadPresetParametersSegment(const int32_t segmentSize)
 }
 
 
+int JpegStreamReader::ReadDefineRestartIntervalSegment(const int32_t segmentSize)
+{
+    // Note: The JPEG-LS standard allows the restart interval size (Ri) to be 2, 3 or 4 bytes (see ISO/IEC 14495-1, C.2.5)
+    switch (segmentSize)
+    {
+    case 2:
+        parameters_.restart_interval = static_cast<uint32_t>(ReadUInt16());
+        break;
+
+    case 3:
+        parameters_.restart_interval = static_cast<uint32_t>(ReadUInt16()) << 8U;
+        parameters_.restart_interval |= ReadByte();
+        break;
+
+    case 4:
+        parameters_.restart_interval = ReadUInt32();
+        break;
+
+    default:
+        throw_jpegls_error(jpegls_errc::invalid_marker_segment_size);
+    }
+
+    return segmentSize;
+}
+
+
 void JpegStreamReader::ReadStartOfScan()
 {
     const int32_t segmentSize = ReadSegmentSize();
@@ -504,8 +834,8 @@ int JpegStreamReader::TryReadApplicationData8Segment(const int32_t segmentSize,
 
 int JpegStreamReader::TryReadHPColorTransformSegment()
 {
-    vector<char> sourceTag;
-    ReadNBytes(sourceTag, 4);
+    array<char, 4> sourceTag;
+    ReadNBytes(sourceTag.data(), static_cast<int>(sourceTag.size()));
     if (strncmp(sourceTag.data(), "mrfx", 4) != 0) // mrfx = xfrm (in big endian) = colorXFoRM
         return 4;
 
@@ -542,8 +872,8 @@ EnumType enum_cast(uint8_t value)
 
 int JpegStreamReader::TryReadSpiffHeaderSegment(OUT_ spiff_header& header, OUT_ bool& spiff_header_found)
 {
-    vector<char> sourceTag;
-    ReadNBytes(sourceTag, 6);
+    array<char, 6> sourceTag;
+    ReadNBytes(sourceTag.data(), static_cast<int>(sourceTag.size()));
     if (strncmp(sourceTag.data(), "SPIFF\0", 6) != 0)
     {
         header = {};
@@ -7,6 +7,7 @@
 #include <charls/public_types.h>
 
 #include "coding_parameters.h"
+#include "jls_codec_factory.h"
 
 #include <cstdint>
 #include <vector>
@@ -20,6 +21,16 @@ class JpegStreamReader final
 {
 public:
     explicit JpegStreamReader(ByteStreamInfo byteStreamInfo) noexcept;
+    ~JpegStreamReader();
+
+    JpegStreamReader(const JpegStreamReader&) = delete;
+    JpegStreamReader(JpegStreamReader&&) = delete;
+    JpegStreamReader& operator=(const JpegStreamReader&) = delete;
+    JpegStreamReader& operator=(JpegStreamReader&&) = delete;
+
+    // Prepares the reader for the next byte stream, as if it was created for it.
+    // The allocator, the codec of the last scan and the allocated buffers are kept for the next image.
+    void Reset(ByteStreamInfo byteStreamInfo) noexcept;
 
     const charls::frame_info& frame_info() const noexcept
     {
@@ -49,6 +60,14 @@ class JpegStreamReader final
         rect_ = rect;
     }
 
+    void SetMaximumThreadCount(const uint32_t value) noexcept
+    {
+        maximum_thread_count_ = value;
+    }
+
+    // The codecs and their buffers are allocated with memory_allocator, the codec of the last scan is released when it changes.
+    void SetAllocator(const charls_allocator& memory_allocator) noexcept;
+
     void ReadStartOfScan();
     uint8_t ReadByte();
 
@@ -57,16 +76,36 @@ class JpegStreamReader final
     int ReadUInt16();
     uint32_t ReadUInt32();
     int32_t ReadSegmentSize();
-    void ReadNBytes(std::vector<char>& destination, int byteCount);
+    void ReadNBytes(char* destination, int byteCount);
     void ReadNextStartOfScan();
     JpegMarkerCode ReadNextMarkerCode();
     void ValidateMarkerCode(JpegMarkerCode markerCode) const;
 
+    struct scan_info
+    {
+        ByteStreamInfo source;
+        coding_parameters parameters;
+        jpegls_pc_parameters preset_coding_parameters;
+    };
+
+    void ReadScan(ByteStreamInfo rawPixels, uint32_t stride);
+    bool CanPipelineLineOutput() const noexcept;
+
+    bool CanReadScansInParallel(ByteStreamInfo rawPixels, uint32_t stride, int64_t bytesPerPlane) const noexcept;
+    bool TryReadScansInParallel(ByteStreamInfo rawPixels, uint32_t stride, int64_t bytesPerPlane);
+    bool FindStartOfScans(std::vector<scan_info>& scans);
+    bool SkipToEndOfScan() noexcept;
+
+    bool CanReadRestartIntervalsInParallel(ByteStreamInfo rawPixels, uint32_t stride) const noexcept;
+    bool TryReadRestartIntervalsInParallel(ByteStreamInfo rawPixels, uint32_t stride);
+    bool FindRestartIntervals(std::vector<ByteStreamInfo>& intervals) const;
+
     int ReadMarkerSegment(JpegMarkerCode markerCode, int32_t segmentSize, spiff_header* header = nullptr, bool* spiff_header_found = nullptr);
     int ReadSpiffDirectoryEntry(JpegMarkerCode markerCode, int32_t segmentSize);
     int ReadStartOfFrameSegment(int32_t segmentSize);
     static int ReadComment() noexcept;
     int ReadPresetParametersSegment(int32_t segmentSize);
+    int ReadDefineRestartIntervalSegment(int32_t segmentSize);
     int TryReadApplicationData8Segment(int32_t segmentSize, spiff_header* header, bool* spiff_header_found);
     int TryReadSpiffHeaderSegment(OUT_ spiff_header& header, OUT_ bool& spiff_header_found);
 
@@ -93,7 +132,10 @@ class JpegStreamReader final
     jpegls_pc_parameters preset_coding_parameters_{};
     JlsRect rect_{};
     std::vector<uint8_t> componentIds_;
+    uint32_t maximum_thread_count_{1};
     state state_{};
+    charls_allocator allocator_{};
+    JlsCodecCache<DecoderStrategy> codecCache_;
 };
 
 } // namespace charls
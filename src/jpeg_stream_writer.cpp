@@ -11,10 +11,10 @@
 
 #include <array>
 #include <cassert>
+#include <cstring>
 #include <vector>
 
 using std::array;
-using std::vector;
 
 namespace charls {
 
@@ -36,27 +36,45 @@ void JpegStreamWriter::WriteEndOfImage()
 }
 
 
+void JpegStreamWriter::WriteBytes(IN_READS_BYTES_(dataSize) const void* data, const size_t dataSize)
+{
+    if (destination_.rawStream)
+    {
+        if (static_cast<size_t>(destination_.rawStream->sputn(static_cast<const char*>(data), static_cast<std::streamsize>(dataSize))) != dataSize)
+            impl::throw_jpegls_error(jpegls_errc::destination_buffer_too_small);
+
+        return;
+    }
+
+    if (dataSize > destination_.count - byteOffset_)
+        impl::throw_jpegls_error(jpegls_errc::destination_buffer_too_small);
+
+    std::memcpy(destination_.rawData + byteOffset_, data, dataSize);
+    byteOffset_ += dataSize;
+}
+
+
 void JpegStreamWriter::WriteSpiffHeaderSegment(const spiff_header& header)
 {
     ASSERT(header.height > 0);
     ASSERT(header.width > 0);
 
     // Create a JPEG APP8 segment in Still Picture Interchange File Format (SPIFF), v2.0
-    vector<uint8_t> segment{'S', 'P', 'I', 'F', 'F', '\0'};
-    segment.push_back(spiff_major_revision_number);
-    segment.push_back(spiff_minor_revision_number);
-    segment.push_back(static_cast<uint8_t>(header.profile_id));
-    segment.push_back(static_cast<uint8_t>(header.component_count));
-    push_back(segment, header.height);
-    push_back(segment, header.width);
-    segment.push_back(static_cast<uint8_t>(header.color_space));
-    segment.push_back(static_cast<uint8_t>(header.bits_per_sample));
-    segment.push_back(static_cast<uint8_t>(header.compression_type));
-    segment.push_back(static_cast<uint8_t>(header.resolution_units));
-    push_back(segment, header.vertical_resolution);
-    push_back(segment, header.horizontal_resolution);
-
-    WriteSegment(JpegMarkerCode::ApplicationData8, segment.data(), segment.size());
+    segment_.assign({'S', 'P', 'I', 'F', 'F', '\0'});
+    segment_.push_back(spiff_major_revision_number);
+    segment_.push_back(spiff_minor_revision_number);
+    segment_.push_back(static_cast<uint8_t>(header.profile_id));
+    segment_.push_back(static_cast<uint8_t>(header.component_count));
+    push_back(segment_, header.height);
+    push_back(segment_, header.width);
+    segment_.push_back(static_cast<uint8_t>(header.color_space));
+    segment_.push_back(static_cast<uint8_t>(header.bits_per_sample));
+    segment_.push_back(static_cast<uint8_t>(header.compression_type));
+    segment_.push_back(static_cast<uint8_t>(header.resolution_units));
+    push_back(segment_, header.vertical_resolution);
+    push_back(segment_, header.horizontal_resolution);
+
+    WriteSegment(JpegMarkerCode::ApplicationData8, segment_.data(), segment_.size());
 }
 
 
@@ -90,25 +108,25 @@ void JpegStreamWriter::WriteStartOfFrameSegment(const int width, const int heigh
     ASSERT(componentCount > 0 && componentCount <= UINT8_MAX);
 
     // Create a Frame Header as defined in ISO/IEC 14495-1, C.2.2 and T.81, B.2.2
-    vector<uint8_t> segment;
-    segment.push_back(static_cast<uint8_t>(bitsPerSample)); // P = Sample precision
-    push_back(segment, static_cast<uint16_t>(height));      // Y = Number of lines
-    push_back(segment, static_cast<uint16_t>(width));       // X = Number of samples per line
+    segment_.clear();
+    segment_.push_back(static_cast<uint8_t>(bitsPerSample)); // P = Sample precision
+    push_back(segment_, static_cast<uint16_t>(height));      // Y = Number of lines
+    push_back(segment_, static_cast<uint16_t>(width));       // X = Number of samples per line
 
     // Components
-    segment.push_back(static_cast<uint8_t>(componentCount)); // Nf = Number of image components in frame
+    segment_.push_back(static_cast<uint8_t>(componentCount)); // Nf = Number of image components in frame
 
     // Use by default 1 as the start component identifier to remain compatible with the
     // code sample of ISO/IEC 14495-1, H.4 and the JPEG-LS ISO conformance sample files.
     for (auto componentId = 1; componentId <= componentCount; ++componentId)
     {
         // Component Specification parameters
-        segment.push_back(static_cast<uint8_t>(componentId)); // Ci = Component identifier
-        segment.push_back(0x11);                              // Hi + Vi = Horizontal sampling factor + Vertical sampling factor
-        segment.push_back(0);                                 // Tqi = Quantization table destination selector (reserved for JPEG-LS, should be set to 0)
+        segment_.push_back(static_cast<uint8_t>(componentId)); // Ci = Component identifier
+        segment_.push_back(0x11);                              // Hi + Vi = Horizontal sampling factor + Vertical sampling factor
+        segment_.push_back(0);                                 // Tqi = Quantization table destination selector (reserved for JPEG-LS, should be set to 0)
     }
 
-    WriteSegment(JpegMarkerCode::StartOfFrameJpegLS, segment.data(), segment.size());
+    WriteSegment(JpegMarkerCode::StartOfFrameJpegLS, segment_.data(), segment_.size());
 }
 
 
@@ -121,17 +139,17 @@ void JpegStreamWriter::WriteColorTransformSegment(const color_transformation tra
 
 void JpegStreamWriter::WriteJpegLSPresetParametersSegment(const jpegls_pc_parameters& preset_coding_parameters)
 {
-    vector<uint8_t> segment;
+    segment_.clear();
 
-    segment.push_back(static_cast<uint8_t>(JpegLSPresetParametersType::PresetCodingParameters));
+    segment_.push_back(static_cast<uint8_t>(JpegLSPresetParametersType::PresetCodingParameters));
 
-    push_back(segment, static_cast<uint16_t>(preset_coding_parameters.maximum_sample_value));
-    push_back(segment, static_cast<uint16_t>(preset_coding_parameters.threshold1));
-    push_back(segment, static_cast<uint16_t>(preset_coding_parameters.threshold2));
-    push_back(segment, static_cast<uint16_t>(preset_coding_parameters.threshold3));
-    push_back(segment, static_cast<uint16_t>(preset_coding_parameters.reset_value));
+    push_back(segment_, static_cast<uint16_t>(preset_coding_parameters.maximum_sample_value));
+    push_back(segment_, static_cast<uint16_t>(preset_coding_parameters.threshold1));
+    push_back(segment_, static_cast<uint16_t>(preset_coding_parameters.threshold2));
+    push_back(segment_, static_cast<uint16_t>(preset_coding_parameters.threshold3));
+    push_back(segment_, static_cast<uint16_t>(preset_coding_parameters.reset_value));
 
-    WriteSegment(JpegMarkerCode::JpegLSPresetParameters, segment.data(), segment.size());
+    WriteSegment(JpegMarkerCode::JpegLSPresetParameters, segment_.data(), segment_.size());
 }
 
 
@@ -146,21 +164,41 @@ void JpegStreamWriter::WriteStartOfScanSegment(const int componentCount,
            interleaveMode == interleave_mode::sample);
 
     // Create a Scan Header as defined in T.87, C.2.3 and T.81, B.2.3
-    vector<uint8_t> segment;
+    segment_.clear();
 
-    segment.push_back(static_cast<uint8_t>(componentCount));
+    segment_.push_back(static_cast<uint8_t>(componentCount));
     for (auto i = 0; i < componentCount; ++i)
     {
-        segment.push_back(static_cast<uint8_t>(componentId_));
+        segment_.push_back(static_cast<uint8_t>(componentId_));
         ++componentId_;
-        segment.push_back(0); // Mapping table selector (0 = no table)
+        segment_.push_back(0); // Mapping table selector (0 = no table)
+    }
+
+    segment_.push_back(static_cast<uint8_t>(allowedLossyError)); // NEAR parameter
+    segment_.push_back(static_cast<uint8_t>(interleaveMode));    // ILV parameter
+    segment_.push_back(0);                                       // transformation
+
+    WriteSegment(JpegMarkerCode::StartOfScan, segment_.data(), segment_.size());
+}
+
+
+void JpegStreamWriter::WriteDefineRestartIntervalSegment(const uint32_t restartInterval)
+{
+    // Create a DRI segment as defined in T.87, C.2.5, the smallest Ri size that can hold the value is used.
+    segment_.clear();
+    if (restartInterval > 0xFFFFFF)
+    {
+        segment_.push_back(static_cast<uint8_t>(restartInterval >> 24));
+    }
+
+    if (restartInterval > UINT16_MAX)
+    {
+        segment_.push_back(static_cast<uint8_t>(restartInterval >> 16));
     }
 
-    segment.push_back(static_cast<uint8_t>(allowedLossyError)); // NEAR parameter
-    segment.push_back(static_cast<uint8_t>(interleaveMode));    // ILV parameter
-    segment.push_back(0);                                       // transformation
+    push_back(segment_, static_cast<uint16_t>(restartInterval));
 
-    WriteSegment(JpegMarkerCode::StartOfScan, segment.data(), segment.size());
+    WriteSegment(JpegMarkerCode::DefineRestartInterval, segment_.data(), segment_.size());
 }
 
 
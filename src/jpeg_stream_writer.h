@@ -67,8 +67,21 @@ class JpegStreamWriter final
     /// <param name="interleaveMode">The interleave mode of the components.</param>
     void WriteStartOfScanSegment(int componentCount, int allowedLossyError, interleave_mode interleaveMode);
 
+    /// <summary>
+    /// Writes a JPEG Define Restart Interval (DRI) segment.
+    /// </summary>
+    /// <param name="restartInterval">The number of lines between the restart markers.</param>
+    void WriteDefineRestartIntervalSegment(uint32_t restartInterval);
+
     void WriteEndOfImage();
 
+    /// <summary>
+    /// Writes bytes that have been prepared outside the writer, for example a scan that was encoded into a separate buffer.
+    /// </summary>
+    /// <param name="data">The bytes to write.</param>
+    /// <param name="dataSize">The number of bytes to write.</param>
+    void WriteBytes(IN_READS_BYTES_(dataSize) const void* data, size_t dataSize);
+
     std::size_t GetBytesWritten() const noexcept
     {
         return byteOffset_;
@@ -95,6 +108,14 @@ class JpegStreamWriter final
         byteOffset_ += byteCount;
     }
 
+    // Prepares the writer for a next image, the scratch buffer of the marker segments is kept.
+    void Reset() noexcept
+    {
+        destination_ = {};
+        byteOffset_ = 0;
+        componentId_ = 1;
+    }
+
     void UpdateDestination(OUT_WRITES_BYTES_(destination_size) void* destination_buffer,
                            const size_t destination_size) noexcept
     {
@@ -133,16 +154,6 @@ class JpegStreamWriter final
         }
     }
 
-    void WriteBytes(IN_READS_BYTES_(dataSize) const void* data, const size_t dataSize)
-    {
-        const auto* bytes = static_cast<const uint8_t*>(data);
-
-        for (std::size_t i = 0; i < dataSize; ++i)
-        {
-            WriteByte(bytes[i]);
-        }
-    }
-
     void WriteUInt16(const uint16_t value)
     {
         WriteByte(static_cast<uint8_t>(value / 0x100));
@@ -166,6 +177,9 @@ class JpegStreamWriter final
     ByteStreamInfo destination_{};
     std::size_t byteOffset_{};
     int8_t componentId_{1};
+
+    // scratch buffer for the marker segments, kept to write the segments of a next image without allocations.
+    std::vector<uint8_t> segment_;
 };
 
 } // namespace charls
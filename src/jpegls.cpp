@@ -9,6 +9,7 @@
 #include "jpegls_preset_coding_parameters.h"
 #include "lookup_table.h"
 #include "lossless_traits.h"
+#include "near_lossless_traits.h"
 #include "util.h"
 
 #include <array>
@@ -19,16 +20,38 @@
 // used to determine how large runs should be encoded at a time.
 const std::array<int, 32> J = {0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 9, 10, 11, 12, 13, 14, 15};
 
+// JRunLengthSum[i] is the sum of (1 << J[n]) for n < i: the number of pixels of the run segments from RUNindex a to b is
+// JRunLengthSum[b] - JRunLengthSum[a], which allows to decode a series of run segments in one step.
+const std::array<int, 33> JRunLengthSum = {0, 1, 2, 3, 4, 6, 8, 10, 12, 16, 20, 24, 28, 36, 44, 52, 60,
+                                           76, 92, 124, 156, 220, 284, 412, 540, 796, 1308, 2332, 4380, 8476, 16668, 33052, 65820};
+
 #include "scan.h"
 
 using std::array;
-using std::make_unique;
-using std::unique_ptr;
 using std::vector;
 using namespace charls;
 
 namespace {
 
+bool equal(const frame_info& lhs, const frame_info& rhs) noexcept
+{
+    return lhs.width == rhs.width && lhs.height == rhs.height && lhs.bits_per_sample == rhs.bits_per_sample &&
+           lhs.component_count == rhs.component_count;
+}
+
+bool equal(const coding_parameters& lhs, const coding_parameters& rhs) noexcept
+{
+    return lhs.near_lossless == rhs.near_lossless && lhs.interleave_mode == rhs.interleave_mode &&
+           lhs.transformation == rhs.transformation && lhs.output_bgr == rhs.output_bgr &&
+           lhs.restart_interval == rhs.restart_interval;
+}
+
+bool equal(const jpegls_pc_parameters& lhs, const jpegls_pc_parameters& rhs) noexcept
+{
+    return lhs.maximum_sample_value == rhs.maximum_sample_value && lhs.threshold1 == rhs.threshold1 &&
+           lhs.threshold2 == rhs.threshold2 && lhs.threshold3 == rhs.threshold3 && lhs.reset_value == rhs.reset_value;
+}
+
 signed char QuantizeGradientOrg(const jpegls_pc_parameters& preset, const int32_t near_lossless, const int32_t Di) noexcept
 {
     if (Di <= -preset.threshold3) return -4;
@@ -57,10 +80,53 @@ vector<signed char> CreateQLutLossless(const int32_t bitCount)
     return lut;
 }
 
+#ifdef USE_COMBINED_CONTEXT_LUT
+// Creates a table that maps the first two gradients of a context (clamped to [-T3, T3]) to their part of the context ID.
+// Differences beyond T3 quantize to the same bin, so the table only needs (2 * T3 + 1)^2 entries (43 x 43 for 8 bit).
+vector<int16_t> CreateContextLutLossless(const int32_t bitCount)
+{
+    const jpegls_pc_parameters preset{compute_default((1U << static_cast<uint32_t>(bitCount)) - 1, 0)};
+    const int32_t stride = 2 * preset.threshold3 + 1;
+
+    vector<int16_t> lut(static_cast<size_t>(stride) * stride);
+
+    for (int32_t diff1 = -preset.threshold3; diff1 <= preset.threshold3; ++diff1)
+    {
+        for (int32_t diff2 = -preset.threshold3; diff2 <= preset.threshold3; ++diff2)
+        {
+            lut[static_cast<size_t>(diff1 + preset.threshold3) * stride + diff2 + preset.threshold3] =
+                static_cast<int16_t>(ComputeContextID(QuantizeGradientOrg(preset, 0, diff1), QuantizeGradientOrg(preset, 0, diff2), 0));
+        }
+    }
+    return lut;
+}
+#endif
+
 template<typename Strategy, typename Traits>
-unique_ptr<Strategy> create_codec(const Traits& traits, const frame_info& frame_info, const coding_parameters& parameters)
+allocated_ptr<Strategy> create_codec(const charls_allocator& memory_allocator, const Traits& traits, const frame_info& frame_info, const coding_parameters& parameters)
 {
-    return make_unique<charls::JlsCodec<Traits, Strategy>>(traits, frame_info, parameters);
+    return allocate_unique<charls::JlsCodec<Traits, Strategy>>(memory_allocator, traits, frame_info, parameters, memory_allocator);
+}
+
+// Creates a codec with NEAR as a compile time constant for the common near-lossless values.
+template<typename Strategy, typename Sample, typename Pixel>
+allocated_ptr<Strategy> create_default_codec(const charls_allocator& memory_allocator, const int32_t maxval, const frame_info& frame_info, const coding_parameters& parameters)
+{
+#ifndef DISABLE_SPECIALIZATIONS
+    switch (parameters.near_lossless)
+    {
+    case 1:
+        return create_codec<Strategy>(memory_allocator, NearLosslessTraits<Sample, Pixel, 1>(maxval), frame_info, parameters);
+    case 2:
+        return create_codec<Strategy>(memory_allocator, NearLosslessTraits<Sample, Pixel, 2>(maxval), frame_info, parameters);
+    case 3:
+        return create_codec<Strategy>(memory_allocator, NearLosslessTraits<Sample, Pixel, 3>(maxval), frame_info, parameters);
+    default:
+        break;
+    }
+#endif
+
+    return create_codec<Strategy>(memory_allocator, DefaultTraits<Sample, Pixel>(maxval, parameters.near_lossless), frame_info, parameters);
 }
 
 } // namespace
@@ -72,10 +138,16 @@ namespace charls {
 // To avoid threading issues, all tables are created when the program is loaded.
 
 // Lookup table: decode symbols that are smaller or equal to 8 bit (16 tables for each value of k)
-array<CTable, 16> decodingTables = {InitTable(0), InitTable(1), InitTable(2), InitTable(3), // NOLINT(clang-diagnostic-global-constructors)
-                                    InitTable(4), InitTable(5), InitTable(6), InitTable(7),
-                                    InitTable(8), InitTable(9), InitTable(10), InitTable(11),
-                                    InitTable(12), InitTable(13), InitTable(14), InitTable(15)};
+array<CTable<8>, 16> decodingTables = {InitTable<8>(0), InitTable<8>(1), InitTable<8>(2), InitTable<8>(3), // NOLINT(clang-diagnostic-global-constructors)
+                                       InitTable<8>(4), InitTable<8>(5), InitTable<8>(6), InitTable<8>(7),
+                                       InitTable<8>(8), InitTable<8>(9), InitTable<8>(10), InitTable<8>(11),
+                                       InitTable<8>(12), InitTable<8>(13), InitTable<8>(14), InitTable<8>(15)};
+
+// Lookup table: decode symbols that are smaller or equal to 12 bit, used for samples larger than 8 bit.
+array<CTable<12>, 16> decodingTables12 = {InitTable<12>(0), InitTable<12>(1), InitTable<12>(2), InitTable<12>(3), // NOLINT(clang-diagnostic-global-constructors)
+                                          InitTable<12>(4), InitTable<12>(5), InitTable<12>(6), InitTable<12>(7),
+                                          InitTable<12>(8), InitTable<12>(9), InitTable<12>(10), InitTable<12>(11),
+                                          InitTable<12>(12), InitTable<12>(13), InitTable<12>(14), InitTable<12>(15)};
 
 // Lookup tables: sample differences to bin indexes.
 vector<signed char> rgquant8Ll = CreateQLutLossless(8);   // NOLINT(clang-diagnostic-global-constructors)
@@ -83,11 +155,16 @@ vector<signed char> rgquant10Ll = CreateQLutLossless(10); // NOLINT(clang-diagno
 vector<signed char> rgquant12Ll = CreateQLutLossless(12); // NOLINT(clang-diagnostic-global-constructors)
 vector<signed char> rgquant16Ll = CreateQLutLossless(16); // NOLINT(clang-diagnostic-global-constructors)
 
+#ifdef USE_COMBINED_CONTEXT_LUT
+// Lookup table: the first two sample differences to a partial context ID.
+vector<int16_t> rgcontext8Ll = CreateContextLutLossless(8); // NOLINT(clang-diagnostic-global-constructors)
+#endif
+
 
 template<typename Strategy>
-unique_ptr<Strategy> JlsCodecFactory<Strategy>::CreateCodec(const frame_info& frame, const coding_parameters& parameters, const jpegls_pc_parameters& preset_coding_parameters)
+allocated_ptr<Strategy> JlsCodecFactory<Strategy>::CreateCodec(const frame_info& frame, const coding_parameters& parameters, const jpegls_pc_parameters& preset_coding_parameters)
 {
-    unique_ptr<Strategy> codec;
+    allocated_ptr<Strategy> codec;
 
     if (preset_coding_parameters.reset_value == 0 || preset_coding_parameters.reset_value == DefaultResetValue)
     {
@@ -100,13 +177,13 @@ unique_ptr<Strategy> JlsCodecFactory<Strategy>::CreateCodec(const frame_info& fr
         {
             DefaultTraits<uint8_t, uint8_t> traits(calculate_maximum_sample_value(frame.bits_per_sample), parameters.near_lossless, preset_coding_parameters.reset_value);
             traits.MAXVAL = preset_coding_parameters.maximum_sample_value;
-            codec = make_unique<JlsCodec<DefaultTraits<uint8_t, uint8_t>, Strategy>>(traits, frame, parameters);
+            codec = allocate_unique<JlsCodec<DefaultTraits<uint8_t, uint8_t>, Strategy>>(allocator_, traits, frame, parameters, allocator_);
         }
         else
         {
             DefaultTraits<uint16_t, uint16_t> traits(calculate_maximum_sample_value(frame.bits_per_sample), parameters.near_lossless, preset_coding_parameters.reset_value);
             traits.MAXVAL = preset_coding_parameters.maximum_sample_value;
-            codec = make_unique<JlsCodec<DefaultTraits<uint16_t, uint16_t>, Strategy>>(traits, frame, parameters);
+            codec = allocate_unique<JlsCodec<DefaultTraits<uint16_t, uint16_t>, Strategy>>(allocator_, traits, frame, parameters, allocator_);
         }
     }
 
@@ -115,7 +192,7 @@ unique_ptr<Strategy> JlsCodecFactory<Strategy>::CreateCodec(const frame_info& fr
 }
 
 template<typename Strategy>
-unique_ptr<Strategy> JlsCodecFactory<Strategy>::CreateOptimizedCodec(const frame_info& frame, const coding_parameters& parameters)
+allocated_ptr<Strategy> JlsCodecFactory<Strategy>::CreateOptimizedCodec(const frame_info& frame, const coding_parameters& parameters)
 {
     if (parameters.interleave_mode == interleave_mode::sample && frame.component_count != 3 && frame.component_count != 4)
         return nullptr;
@@ -127,21 +204,53 @@ unique_ptr<Strategy> JlsCodecFactory<Strategy>::CreateOptimizedCodec(const frame
     {
         if (parameters.interleave_mode == interleave_mode::sample)
         {
-            if (frame.component_count == 3 && frame.bits_per_sample == 8)
-                return create_codec<Strategy>(LosslessTraits<Triplet<uint8_t>, 8>(), frame, parameters);
-            if (frame.component_count == 4 && frame.bits_per_sample == 8)
-                return create_codec<Strategy>(LosslessTraits<Quad<uint8_t>, 8>(), frame, parameters);
+            if (frame.component_count == 3)
+            {
+                switch (frame.bits_per_sample)
+                {
+                case 8:
+                    return create_codec<Strategy>(allocator_, LosslessTraits<Triplet<uint8_t>, 8>(), frame, parameters);
+                case 10:
+                    return create_codec<Strategy>(allocator_, LosslessTraits<Triplet<uint16_t>, 10>(), frame, parameters);
+                case 12:
+                    return create_codec<Strategy>(allocator_, LosslessTraits<Triplet<uint16_t>, 12>(), frame, parameters);
+                case 16:
+                    return create_codec<Strategy>(allocator_, LosslessTraits<Triplet<uint16_t>, 16>(), frame, parameters);
+                default:
+                    break;
+                }
+            }
+            else
+            {
+                switch (frame.bits_per_sample)
+                {
+                case 8:
+                    return create_codec<Strategy>(allocator_, LosslessTraits<Quad<uint8_t>, 8>(), frame, parameters);
+                case 10:
+                    return create_codec<Strategy>(allocator_, LosslessTraits<Quad<uint16_t>, 10>(), frame, parameters);
+                case 12:
+                    return create_codec<Strategy>(allocator_, LosslessTraits<Quad<uint16_t>, 12>(), frame, parameters);
+                case 16:
+                    return create_codec<Strategy>(allocator_, LosslessTraits<Quad<uint16_t>, 16>(), frame, parameters);
+                default:
+                    break;
+                }
+            }
         }
         else
         {
             switch (frame.bits_per_sample)
             {
             case 8:
-                return create_codec<Strategy>(LosslessTraits<uint8_t, 8>(), frame, parameters);
+                return create_codec<Strategy>(allocator_, LosslessTraits<uint8_t, 8>(), frame, parameters);
+            case 10:
+                return create_codec<Strategy>(allocator_, LosslessTraits<uint16_t, 10>(), frame, parameters);
             case 12:
-                return create_codec<Strategy>(LosslessTraits<uint16_t, 12>(), frame, parameters);
+                return create_codec<Strategy>(allocator_, LosslessTraits<uint16_t, 12>(), frame, parameters);
+            case 14:
+                return create_codec<Strategy>(allocator_, LosslessTraits<uint16_t, 14>(), frame, parameters);
             case 16:
-                return create_codec<Strategy>(LosslessTraits<uint16_t, 16>(), frame, parameters);
+                return create_codec<Strategy>(allocator_, LosslessTraits<uint16_t, 16>(), frame, parameters);
             default:
                 break;
             }
@@ -157,24 +266,24 @@ unique_ptr<Strategy> JlsCodecFactory<Strategy>::CreateOptimizedCodec(const frame
         if (parameters.interleave_mode == interleave_mode::sample)
         {
             if (frame.component_count == 3)
-                return create_codec<Strategy>(DefaultTraits<uint8_t, Triplet<uint8_t>>(maxval, parameters.near_lossless), frame, parameters);
+                return create_default_codec<Strategy, uint8_t, Triplet<uint8_t>>(allocator_, maxval, frame, parameters);
             if (frame.component_count == 4)
-                return create_codec<Strategy>(DefaultTraits<uint8_t, Quad<uint8_t>>(maxval, parameters.near_lossless), frame, parameters);
+                return create_default_codec<Strategy, uint8_t, Quad<uint8_t>>(allocator_, maxval, frame, parameters);
         }
 
-        return create_codec<Strategy>(DefaultTraits<uint8_t, uint8_t>(maxval, parameters.near_lossless), frame, parameters);
+        return create_default_codec<Strategy, uint8_t, uint8_t>(allocator_, maxval, frame, parameters);
     }
     if (frame.bits_per_sample <= 16)
     {
         if (parameters.interleave_mode == interleave_mode::sample)
         {
             if (frame.component_count == 3)
-                return create_codec<Strategy>(DefaultTraits<uint16_t, Triplet<uint16_t>>(maxval, parameters.near_lossless), frame, parameters);
+                return create_default_codec<Strategy, uint16_t, Triplet<uint16_t>>(allocator_, maxval, frame, parameters);
             if (frame.component_count == 4)
-                return create_codec<Strategy>(DefaultTraits<uint16_t, Quad<uint16_t>>(maxval, parameters.near_lossless), frame, parameters);
+                return create_default_codec<Strategy, uint16_t, Quad<uint16_t>>(allocator_, maxval, frame, parameters);
         }
 
-        return create_codec<Strategy>(DefaultTraits<uint16_t, uint16_t>(maxval, parameters.near_lossless), frame, parameters);
+        return create_default_codec<Strategy, uint16_t, uint16_t>(allocator_, maxval, frame, parameters);
     }
     return nullptr;
 }
@@ -183,4 +292,34 @@ unique_ptr<Strategy> JlsCodecFactory<Strategy>::CreateOptimizedCodec(const frame
 template class JlsCodecFactory<DecoderStrategy>;
 template class JlsCodecFactory<EncoderStrategy>;
 
+
+template<typename Strategy>
+Strategy& JlsCodecCache<Strategy>::GetCodec(const frame_info& frame, const coding_parameters& parameters, const jpegls_pc_parameters& preset_coding_parameters,
+                                            const charls_allocator& memory_allocator)
+{
+    if (!codec_ || !equal(frame_, frame) || !equal(parameters_, parameters) || !equal(preset_coding_parameters_, preset_coding_parameters) ||
+        allocator_ != memory_allocator)
+    {
+        codec_.reset();
+        codec_ = JlsCodecFactory<Strategy>(memory_allocator).CreateCodec(frame, parameters, preset_coding_parameters);
+        allocator_ = memory_allocator;
+        frame_ = frame;
+        parameters_ = parameters;
+        preset_coding_parameters_ = preset_coding_parameters;
+    }
+
+    return *codec_;
+}
+
+
+template<typename Strategy>
+void JlsCodecCache<Strategy>::Clear() noexcept
+{
+    codec_.reset();
+}
+
+
+template class JlsCodecCache<DecoderStrategy>;
+template class JlsCodecCache<EncoderStrategy>;
+
 } // namespace charls
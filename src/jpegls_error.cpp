@@ -101,6 +101,9 @@ const char* CHARLS_API_CALLING_CONVENTION charls_get_error_message(const charls_
     case jpegls_errc::missing_end_of_spiff_directory:
         return "Invalid JPEG-LS stream, SPIFF header without End Of Directory (EOD) entry";
 
+    case jpegls_errc::restart_marker_not_found:
+        return "Invalid JPEG-LS stream, the expected Restart (RSTm) marker is not found";
+
     case jpegls_errc::invalid_parameter_bits_per_sample:
         return "Invalid JPEG-LS stream, The bit per sample (sample precision) parameter is not in the range [2, 16]";
 
@@ -11,14 +11,16 @@
 namespace charls {
 
 // Tables for fast decoding of short Golomb Codes.
+// The entries are kept small (4 bytes) to keep the wider tables cache friendly.
 struct Code final
 {
     Code() = default;
 
     Code(const int32_t value, const int32_t length) noexcept :
-        value_{value},
-        length_{length}
+        value_{static_cast<int16_t>(value)},
+        length_{static_cast<uint8_t>(length)}
     {
+        ASSERT(value_ == value && length_ == length);
     }
 
     int32_t GetValue() const noexcept
@@ -31,25 +33,28 @@ struct Code final
         return length_;
     }
 
-    int32_t value_{};
-    int32_t length_{};
+    int16_t value_{};
+    uint8_t length_{};
 };
 
 
+// Purpose: lookup table indexed by the next LookupBitCount bits of the bit stream.
+//          Every code with a length of at most LookupBitCount bits has an entry.
+template<size_t LookupBitCount>
 class CTable final
 {
 public:
-    static constexpr size_t byte_bit_count = 8;
+    static constexpr size_t lookup_bit_count = LookupBitCount;
 
-    void AddEntry(const uint8_t value, const Code c) noexcept
+    void AddEntry(const uint32_t value, const Code c) noexcept
     {
         const int32_t length = c.GetLength();
-        ASSERT(static_cast<size_t>(length) <= byte_bit_count);
+        ASSERT(static_cast<size_t>(length) <= lookup_bit_count);
 
-        for (size_t i = 0; i < static_cast<size_t>(1U) << (byte_bit_count - length); ++i)
+        for (size_t i = 0; i < static_cast<size_t>(1U) << (lookup_bit_count - length); ++i)
         {
-            ASSERT(types_[(static_cast<size_t>(value) << (byte_bit_count - length)) + i].GetLength() == 0);
-            types_[(static_cast<size_t>(value) << (byte_bit_count - length)) + i] = c;
+            ASSERT(types_[(static_cast<size_t>(value) << (lookup_bit_count - length)) + i].GetLength() == 0);
+            types_[(static_cast<size_t>(value) << (lookup_bit_count - length)) + i] = c;
         }
     }
 
@@ -59,7 +64,7 @@ class CTable final
     }
 
 private:
-    std::array<Code, 1 << byte_bit_count> types_;
+    std::array<Code, 1 << lookup_bit_count> types_;
 };
 
 } // namespace charls
@@ -10,7 +10,7 @@
 
 namespace charls {
 
-// Optimized trait classes for lossless compression of 8 bit color and 8/16 bit monochrome images.
+// Optimized trait classes for lossless compression of 8/10/12/16 bit color and 8/10/12/14/16 bit monochrome images.
 // This class assumes MaximumSampleValue correspond to a whole number of bits, and no custom ResetValue is set when encoding.
 // The point of this is to have the most optimized code for the most common and most demanding scenario.
 template<typename sample, int32_t bitsPerPixel>
@@ -132,7 +132,7 @@ struct LosslessTraits<Triplet<T>, bpp> final : LosslessTraitsImpl<T, bpp>
 
     FORCE_INLINE static T ComputeReconstructedSample(const int32_t Px, const int32_t errorValue) noexcept
     {
-        return static_cast<T>(Px + errorValue);
+        return static_cast<T>(LosslessTraitsImpl<T, bpp>::MAXVAL & (Px + errorValue));
     }
 };
 
@@ -154,7 +154,7 @@ struct LosslessTraits<Quad<T>, bpp> final : LosslessTraitsImpl<T, bpp>
 
     FORCE_INLINE static T ComputeReconstructedSample(const int32_t Px, const int32_t errorValue) noexcept
     {
-        return static_cast<T>(Px + errorValue);
+        return static_cast<T>(LosslessTraitsImpl<T, bpp>::MAXVAL & (Px + errorValue));
     }
 };
 
@@ -0,0 +1,164 @@
+// Copyright (c) Team CharLS.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#include <charls/public_types.h>
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace charls {
+
+// Purpose: allocates and releases memory with the custom allocator of an encoder or decoder instance.
+//          An allocator without an allocate function (the default) uses the global operator new and delete.
+inline void* allocate_memory(const charls_allocator& memory_allocator, const size_t size, const size_t alignment)
+{
+    if (!memory_allocator.allocate)
+        return ::operator new(size);
+
+    void* memory = memory_allocator.allocate(memory_allocator.user_context, size, alignment);
+    if (!memory)
+        throw std::bad_alloc();
+
+    return memory;
+}
+
+inline void deallocate_memory(const charls_allocator& memory_allocator, void* memory, const size_t size, const size_t alignment) noexcept
+{
+    if (!memory_allocator.allocate)
+    {
+        ::operator delete(memory);
+        return;
+    }
+
+    memory_allocator.deallocate(memory_allocator.user_context, memory, size, alignment);
+}
+
+inline bool operator==(const charls_allocator& lhs, const charls_allocator& rhs) noexcept
+{
+    return lhs.allocate == rhs.allocate && lhs.deallocate == rhs.deallocate && lhs.user_context == rhs.user_context;
+}
+
+inline bool operator!=(const charls_allocator& lhs, const charls_allocator& rhs) noexcept
+{
+    return !(lhs == rhs);
+}
+
+
+// Purpose: standard library allocator that allocates the elements of a container with a custom allocator.
+//          Assigning a container also assigns its allocator: a container can be replaced by one that uses another allocator.
+// Note: not final, the standard library implementations derive from the allocator (empty base optimization).
+template<typename T>
+class allocator_adapter
+{
+public:
+    using value_type = T;
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+
+    allocator_adapter() noexcept = default;
+
+    explicit allocator_adapter(const charls_allocator& memory_allocator) noexcept :
+        allocator_{memory_allocator}
+    {
+    }
+
+    template<typename U>
+    allocator_adapter(const allocator_adapter<U>& other) noexcept : // NOLINT(google-explicit-constructor)
+        allocator_{other.allocator()}
+    {
+    }
+
+    T* allocate(const size_t count)
+    {
+        return static_cast<T*>(allocate_memory(allocator_, count * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T* memory, const size_t count) noexcept
+    {
+        deallocate_memory(allocator_, memory, count * sizeof(T), alignof(T));
+    }
+
+    const charls_allocator& allocator() const noexcept
+    {
+        return allocator_;
+    }
+
+private:
+    charls_allocator allocator_{};
+};
+
+template<typename T, typename U>
+bool operator==(const allocator_adapter<T>& lhs, const allocator_adapter<U>& rhs) noexcept
+{
+    return lhs.allocator() == rhs.allocator();
+}
+
+template<typename T, typename U>
+bool operator!=(const allocator_adapter<T>& lhs, const allocator_adapter<U>& rhs) noexcept
+{
+    return !(lhs == rhs);
+}
+
+// Vector that allocates its elements with a custom allocator.
+template<typename T>
+using allocated_vector = std::vector<T, allocator_adapter<T>>;
+
+
+// Purpose: deleter of objects created by allocate_unique, it remembers the memory block of the complete object.
+//          This allows a unique_ptr to a base class to release the object with the deallocate function.
+class allocated_object_deleter final
+{
+public:
+    allocated_object_deleter() noexcept = default;
+
+    allocated_object_deleter(const charls_allocator& memory_allocator, void* memory, const size_t size, const size_t alignment) noexcept :
+        allocator_{memory_allocator},
+        memory_{memory},
+        size_{size},
+        alignment_{alignment}
+    {
+    }
+
+    template<typename T>
+    void operator()(T* object) const noexcept
+    {
+        object->~T();
+        deallocate_memory(allocator_, memory_, size_, alignment_);
+    }
+
+private:
+    charls_allocator allocator_{};
+    void* memory_{};
+    size_t size_{};
+    size_t alignment_{};
+};
+
+template<typename T>
+using allocated_ptr = std::unique_ptr<T, allocated_object_deleter>;
+
+template<typename T, typename... Args>
+allocated_ptr<T> allocate_unique(const charls_allocator& memory_allocator, Args&&... args)
+{
+    void* memory = allocate_memory(memory_allocator, sizeof(T), alignof(T));
+    T* object;
+    try
+    {
+        object = new (memory) T(std::forward<Args>(args)...);
+    }
+    catch (...)
+    {
+        deallocate_memory(memory_allocator, memory, sizeof(T), alignof(T));
+        throw;
+    }
+
+    return allocated_ptr<T>(object, allocated_object_deleter(memory_allocator, memory, sizeof(T), alignof(T)));
+}
+
+} // namespace charls
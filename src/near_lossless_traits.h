@@ -0,0 +1,136 @@
+// Copyright (c) Team CharLS.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#include "constants.h"
+#include "util.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace charls {
+
+// Optimized trait classes for near-lossless compression with the common NEAR values.
+// NEAR is a compile time constant: the divisions and multiplications by (2 * NEAR + 1) of the (de)quantization
+// are replaced by the compiler with multiply and shift sequences. MAXVAL and the values derived from it are set at runtime.
+// The results are identical to DefaultTraits with the same MAXVAL and NEAR values.
+template<typename sample, typename pixel, int32_t nearLossless>
+struct NearLosslessTraits final
+{
+    using SAMPLE = sample;
+    using PIXEL = pixel;
+
+    static_assert(nearLossless > 0, "Use LosslessTraits or DefaultTraits for lossless coding");
+
+    enum
+    {
+        NEAR = nearLossless,
+        QUANTIZATION_STEP = 2 * nearLossless + 1
+    };
+
+    const int32_t MAXVAL;
+    const int32_t RANGE;
+    const int32_t qbpp;
+    const int32_t bpp;
+    const int32_t LIMIT;
+    const int32_t RESET;
+
+    explicit NearLosslessTraits(const int32_t max, const int32_t reset = DefaultResetValue) noexcept :
+        MAXVAL{max},
+        RANGE{(max + 2 * NEAR) / QUANTIZATION_STEP + 1},
+        qbpp{log_2(RANGE)},
+        bpp{log_2(max)},
+        LIMIT{2 * (bpp + std::max(8, bpp))},
+        RESET{reset}
+    {
+    }
+
+    NearLosslessTraits(const NearLosslessTraits&) noexcept = default;
+    NearLosslessTraits(NearLosslessTraits&&) noexcept = default;
+    ~NearLosslessTraits() = default;
+    NearLosslessTraits& operator=(const NearLosslessTraits&) = delete;
+    NearLosslessTraits& operator=(NearLosslessTraits&&) = delete;
+
+    FORCE_INLINE int32_t ComputeErrVal(const int32_t e) const noexcept
+    {
+        return ModuloRange(Quantize(e));
+    }
+
+    FORCE_INLINE SAMPLE ComputeReconstructedSample(const int32_t Px, const int32_t ErrVal) const noexcept
+    {
+        return FixReconstructedValue(Px + ErrVal * QUANTIZATION_STEP);
+    }
+
+    FORCE_INLINE static bool IsNear(const int32_t lhs, const int32_t rhs) noexcept
+    {
+        return std::abs(lhs - rhs) <= NEAR;
+    }
+
+    static bool IsNear(const Triplet<SAMPLE> lhs, const Triplet<SAMPLE> rhs) noexcept
+    {
+        return std::abs(lhs.v1 - rhs.v1) <= NEAR &&
+               std::abs(lhs.v2 - rhs.v2) <= NEAR &&
+               std::abs(lhs.v3 - rhs.v3) <= NEAR;
+    }
+
+    static bool IsNear(const Quad<SAMPLE> lhs, const Quad<SAMPLE> rhs) noexcept
+    {
+        return std::abs(lhs.v1 - rhs.v1) <= NEAR &&
+               std::abs(lhs.v2 - rhs.v2) <= NEAR &&
+               std::abs(lhs.v3 - rhs.v3) <= NEAR &&
+               std::abs(lhs.v4 - rhs.v4) <= NEAR;
+    }
+
+    FORCE_INLINE int32_t CorrectPrediction(const int32_t Pxc) const noexcept
+    {
+        if ((Pxc & MAXVAL) == Pxc)
+            return Pxc;
+
+        return (~(Pxc >> (int32_t_bit_count - 1))) & MAXVAL;
+    }
+
+    // Returns the value of errorValue modulo RANGE. ITU.T.87, A.4.5 (code segment A.9)
+    FORCE_INLINE int32_t ModuloRange(int32_t errorValue) const noexcept
+    {
+        ASSERT(std::abs(errorValue) <= RANGE);
+
+        if (errorValue < 0)
+        {
+            errorValue += RANGE;
+        }
+
+        if (errorValue >= (RANGE + 1) / 2)
+        {
+            errorValue -= RANGE;
+        }
+
+        return errorValue;
+    }
+
+private:
+    // Both dividends are positive: an unsigned division by a constant needs no sign correction.
+    FORCE_INLINE static int32_t Quantize(const int32_t errorValue) noexcept
+    {
+        if (errorValue > 0)
+            return static_cast<int32_t>(static_cast<uint32_t>(errorValue + NEAR) / QUANTIZATION_STEP);
+
+        return -static_cast<int32_t>(static_cast<uint32_t>(NEAR - errorValue) / QUANTIZATION_STEP);
+    }
+
+    FORCE_INLINE SAMPLE FixReconstructedValue(int32_t value) const noexcept
+    {
+        if (value < -NEAR)
+        {
+            value = value + RANGE * QUANTIZATION_STEP;
+        }
+        else if (value > MAXVAL + NEAR)
+        {
+            value = value - RANGE * QUANTIZATION_STEP;
+        }
+
+        return static_cast<SAMPLE>(CorrectPrediction(value));
+    }
+};
+
+} // namespace charls
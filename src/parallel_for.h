@@ -0,0 +1,92 @@
+// Copyright (c) Team CharLS.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace charls {
+
+// Purpose: returns the number of threads to use when the caller requested the given maximum.
+//          A maximum of 0 means: use all the hardware threads that are available.
+inline uint32_t effective_thread_count(const uint32_t maximum_thread_count) noexcept
+{
+    if (maximum_thread_count != 0)
+        return maximum_thread_count;
+
+    return std::max(1U, std::thread::hardware_concurrency());
+}
+
+
+// Purpose: executes job(index) for every index in [0, job_count) using at most maximum_thread_count threads.
+//          The calling thread also executes jobs. The first exception thrown by a job is re-thrown on
+//          the calling thread after all started jobs have completed; remaining jobs are skipped.
+template<typename Job>
+void parallel_for(const size_t job_count, const uint32_t maximum_thread_count, Job job)
+{
+    const size_t thread_count{std::min(job_count, static_cast<size_t>(effective_thread_count(maximum_thread_count)))};
+    if (thread_count <= 1)
+    {
+        for (size_t i = 0; i < job_count; ++i)
+        {
+            job(i);
+        }
+        return;
+    }
+
+    std::atomic<size_t> next_job{};
+    std::atomic<bool> failed{};
+    std::exception_ptr first_exception;
+    std::mutex exception_mutex;
+
+    const auto worker = [&]() noexcept {
+        for (size_t i = next_job++; i < job_count && !failed; i = next_job++)
+        {
+            try
+            {
+                job(i);
+            }
+            catch (...)
+            {
+                const std::lock_guard<std::mutex> lock(exception_mutex);
+                if (!first_exception)
+                {
+                    first_exception = std::current_exception();
+                }
+                failed = true;
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(thread_count - 1);
+    try
+    {
+        for (size_t i = 1; i < thread_count; ++i)
+        {
+            threads.emplace_back(worker);
+        }
+    }
+    catch (...)
+    {
+        // Failing to start a thread is not fatal: the threads that are running (including this one) take over.
+    }
+
+    worker();
+
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    if (first_exception)
+        std::rethrow_exception(first_exception);
+}
+
+} // namespace charls
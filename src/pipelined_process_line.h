@@ -0,0 +1,316 @@
+// Copyright (c) Team CharLS.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#include "memory_allocator.h"
+#include "process_line.h"
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace charls {
+
+// Purpose: decorator that moves the work of the target ProcessLine (color transforms, (de)interleaving, byte swapping,
+//          copying from the source or to the destination) from the coding thread to a helper thread.
+//          The lines are passed through a single-producer/single-consumer ring of line buffers:
+//          - decoding: the decoder fills the ring with decoded lines, the helper thread drains it (NewLineDecoded).
+//          - encoding: the helper thread prepares the next lines of the scan, the encoder drains the ring (NewLineRequested).
+//          The coding thread only waits when the ring is full (decoding) or empty (encoding).
+//          A waiting thread spins briefly and then blocks until the other thread signals progress.
+// Note: a pipeline is used for a single scan and a single direction. Flush must be called after the last line has
+//       been coded, it waits for the helper thread and re-throws any exception thrown by the target.
+//       Stop must be called when the coding of the scan fails.
+class PipelinedProcessLine final : public ProcessLine
+{
+public:
+    PipelinedProcessLine(allocated_ptr<ProcessLine> target, const frame_info& info, const coding_parameters& parameters,
+                         const charls_allocator& memory_allocator = {}) :
+        target_{std::move(target)},
+        lineCount_{info.height}
+    {
+        for (auto& slot : ring_)
+        {
+            slot.data = allocated_vector<uint8_t>(allocator_adapter<uint8_t>(memory_allocator));
+        }
+
+        // The codec passes a line of every component (line interleave) or a line of pixels (sample interleave).
+        const size_t bytesPerSample = info.bits_per_sample <= 8 ? 1 : 2;
+        if (parameters.interleave_mode == interleave_mode::line)
+        {
+            componentLineCount_ = info.component_count;
+            bytesPerPixel_ = bytesPerSample;
+        }
+        else
+        {
+            componentLineCount_ = 1;
+            bytesPerPixel_ = bytesPerSample * info.component_count;
+        }
+    }
+
+    ~PipelinedProcessLine() override
+    {
+        Stop();
+    }
+
+    PipelinedProcessLine(const PipelinedProcessLine&) = delete;
+    PipelinedProcessLine(PipelinedProcessLine&&) = delete;
+    PipelinedProcessLine& operator=(const PipelinedProcessLine&) = delete;
+    PipelinedProcessLine& operator=(PipelinedProcessLine&&) = delete;
+
+    void NewLineDecoded(const void* pSrc, const int pixelCount, const int sourceStride) override
+    {
+        if (!started_)
+        {
+            Start([this]() noexcept { DrainLines(); });
+        }
+
+        if (!thread_.joinable())
+        {
+            target_->NewLineDecoded(pSrc, pixelCount, sourceStride);
+            return;
+        }
+
+        const size_t head = head_.load(std::memory_order_relaxed);
+        WaitUntil([this, head] {
+            return head - tail_.load(std::memory_order_acquire) != RingSize || failed_.load(std::memory_order_acquire);
+        });
+        if (failed_.load(std::memory_order_acquire))
+            std::rethrow_exception(exception_);
+
+        // The components of a line are sourceStride pixels apart, only the part that will be read is copied.
+        line& destination = ring_[head % RingSize];
+        const size_t byteCount = LineSize(pixelCount, sourceStride);
+        destination.data.resize(byteCount);
+        std::memcpy(destination.data.data(), pSrc, byteCount);
+        destination.pixelCount = pixelCount;
+        destination.stride = sourceStride;
+
+        head_.store(head + 1, std::memory_order_release);
+        Notify();
+    }
+
+    void NewLineRequested(void* pDest, const int pixelCount, const int destStride) override
+    {
+        if (!started_)
+        {
+            // All lines of a scan have the same size: the helper thread can prepare them in advance.
+            pixelCount_ = pixelCount;
+            stride_ = destStride;
+            Start([this]() noexcept { FillLines(); });
+        }
+
+        if (!thread_.joinable())
+        {
+            target_->NewLineRequested(pDest, pixelCount, destStride);
+            return;
+        }
+
+        ASSERT(pixelCount == pixelCount_ && destStride == stride_);
+
+        // The helper thread sets failed_ after it has published its last line: lines prepared before the failure are used first.
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        WaitUntil([this, tail] {
+            return tail != head_.load(std::memory_order_acquire) || failed_.load(std::memory_order_acquire);
+        });
+        if (tail == head_.load(std::memory_order_acquire))
+            std::rethrow_exception(exception_);
+
+        // Copy only the samples of every component line, the padding between the component lines belongs to the encoder.
+        const line& source = ring_[tail % RingSize];
+        const size_t componentLineSize = static_cast<size_t>(pixelCount) * bytesPerPixel_;
+        for (int32_t component = 0; component < componentLineCount_; ++component)
+        {
+            const size_t offset = static_cast<size_t>(component) * destStride * bytesPerPixel_;
+            std::memcpy(static_cast<uint8_t*>(pDest) + offset, source.data.data() + offset, componentLineSize);
+        }
+
+        tail_.store(tail + 1, std::memory_order_release);
+        Notify();
+    }
+
+    void Flush()
+    {
+        if (!thread_.joinable())
+            return;
+
+        done_.store(true, std::memory_order_release);
+        Notify();
+        thread_.join();
+
+        if (failed_)
+            std::rethrow_exception(exception_);
+    }
+
+    // Stops the helper thread without processing the remaining lines, used when the scan is aborted by an exception.
+    // After Stop returns the target is no longer accessed: the caller may release the source or destination.
+    void Stop() noexcept
+    {
+        if (!thread_.joinable())
+            return;
+
+        stop_ = true;
+        Notify();
+        thread_.join();
+    }
+
+private:
+    template<typename Function>
+    void Start(Function function) noexcept
+    {
+        started_ = true;
+        try
+        {
+            thread_ = std::thread(function);
+        }
+        catch (...)
+        {
+            // Failing to start the helper thread is not fatal: the lines are processed on the coding thread.
+        }
+    }
+
+    // The other thread usually makes progress within a short time: spin briefly before blocking on the condition variable.
+    template<typename Condition>
+    void WaitUntil(Condition condition)
+    {
+        for (int i = 0; i < SpinCount; ++i)
+        {
+            if (condition())
+                return;
+
+            std::this_thread::yield();
+        }
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        waiterCount_.fetch_add(1);
+
+        // Pairs with the fence in Notify: either the waiter sees the new state or the notifier sees the waiter.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        progress_.wait(lock, condition);
+        waiterCount_.fetch_sub(1);
+    }
+
+    // Wakes a blocked thread after the state it waits for (head_, tail_, done_, stop_ or failed_) has changed.
+    // The mutex is only taken when a thread is blocked, passing lines through the ring remains lock-free.
+    void Notify() noexcept
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiterCount_.load(std::memory_order_relaxed) == 0)
+            return;
+
+        const std::lock_guard<std::mutex> lock(mutex_);
+        progress_.notify_all();
+    }
+
+    size_t LineSize(const int pixelCount, const int stride) const noexcept
+    {
+        return (static_cast<size_t>(componentLineCount_ - 1) * stride + pixelCount) * bytesPerPixel_;
+    }
+
+    // Helper thread of the decoder: passes the decoded lines to the target.
+    void DrainLines() noexcept
+    {
+        size_t tail{};
+        for (;;)
+        {
+            WaitUntil([this, tail] {
+                return stop_ || done_.load(std::memory_order_acquire) || tail != head_.load(std::memory_order_acquire);
+            });
+            if (stop_)
+                return;
+
+            // Read done_ before head_: when the decoder has finished, head_ contains the final line count.
+            const bool done = done_.load(std::memory_order_acquire);
+            if (tail == head_.load(std::memory_order_acquire))
+            {
+                if (done)
+                    return;
+
+                continue;
+            }
+
+            const line& source = ring_[tail % RingSize];
+            try
+            {
+                target_->NewLineDecoded(source.data.data(), source.pixelCount, source.stride);
+            }
+            catch (...)
+            {
+                exception_ = std::current_exception();
+                failed_.store(true, std::memory_order_release);
+                Notify();
+                return;
+            }
+
+            tail_.store(++tail, std::memory_order_release);
+            Notify();
+        }
+    }
+
+    // Helper thread of the encoder: requests the lines of the scan from the target.
+    // Note: exactly lineCount_ lines are requested, the target may not be able to provide more.
+    void FillLines() noexcept
+    {
+        for (size_t head = 0; head < lineCount_; ++head)
+        {
+            WaitUntil([this, head] { return stop_ || head - tail_.load(std::memory_order_acquire) != RingSize; });
+            if (stop_)
+                return;
+
+            line& destination = ring_[head % RingSize];
+            destination.data.resize(LineSize(pixelCount_, stride_));
+            try
+            {
+                target_->NewLineRequested(destination.data.data(), pixelCount_, stride_);
+            }
+            catch (...)
+            {
+                exception_ = std::current_exception();
+                failed_.store(true, std::memory_order_release);
+                Notify();
+                return;
+            }
+
+            head_.store(head + 1, std::memory_order_release);
+            Notify();
+        }
+    }
+
+    struct line
+    {
+        allocated_vector<uint8_t> data;
+        int pixelCount{};
+        int stride{};
+    };
+
+    static constexpr size_t RingSize = 8;
+    static constexpr int SpinCount = 64;
+
+    allocated_ptr<ProcessLine> target_;
+    size_t lineCount_;
+    int32_t componentLineCount_;
+    size_t bytesPerPixel_;
+    int pixelCount_{};
+    int stride_{};
+    bool started_{};
+    std::array<line, RingSize> ring_;
+    std::atomic<size_t> head_{};
+    std::atomic<size_t> tail_{};
+    std::atomic<bool> done_{};
+    std::atomic<bool> stop_{};
+    std::atomic<bool> failed_{};
+    std::atomic<int> waiterCount_{};
+    std::mutex mutex_;
+    std::condition_variable progress_;
+    std::exception_ptr exception_;
+    std::thread thread_;
+};
+
+} // namespace charls
@@ -7,11 +7,16 @@
 #include <charls/jpegls_error.h>
 
 #include "coding_parameters.h"
+#include "color_transform.h"
+#include "cpu_features.h"
+#include "memory_allocator.h"
+#include "simd.h"
 #include "util.h"
 
 #include <algorithm>
 #include <cstring>
 #include <sstream>
+#include <type_traits>
 #include <vector>
 
 
@@ -39,6 +44,20 @@ class ProcessLine
     virtual void NewLineDecoded(const void* pSrc, int pixelCount, int sourceStride) = 0;
     virtual void NewLineRequested(void* pDest, int pixelCount, int destStride) = 0;
 
+    // Returns the first line when the lines are stored unconverted in a buffer, the codec can then code them in place.
+    // stride receives the distance in bytes between the lines. Returns nullptr when the lines must be passed one at a time.
+    virtual uint8_t* InPlaceLines(size_t& /*stride*/) noexcept
+    {
+        return nullptr;
+    }
+
+    // Prepares the object for the lines of a next scan with the same frame info and coding parameters.
+    // Returns false when the object cannot be used for info, the codec then creates a new object.
+    virtual bool Reset(ByteStreamInfo /*info*/, uint32_t /*stride*/) noexcept
+    {
+        return false;
+    }
+
 protected:
     ProcessLine() = default;
 };
@@ -66,6 +85,22 @@ class PostProcessSingleComponent final : public ProcessLine
         rawData_ += bytesPerLine_;
     }
 
+    uint8_t* InPlaceLines(size_t& stride) noexcept override
+    {
+        stride = bytesPerLine_;
+        return rawData_;
+    }
+
+    bool Reset(const ByteStreamInfo info, const uint32_t stride) noexcept override
+    {
+        if (!info.rawData)
+            return false;
+
+        rawData_ = info.rawData;
+        bytesPerLine_ = stride;
+        return true;
+    }
+
 private:
     uint8_t* rawData_;
     size_t bytesPerPixel_;
@@ -133,6 +168,16 @@ class PostProcessSingleStream final : public ProcessLine
             throw jpegls_error{jpegls_errc::destination_buffer_too_small};
     }
 
+    bool Reset(const ByteStreamInfo info, const uint32_t stride) noexcept override
+    {
+        if (!info.rawStream)
+            return false;
+
+        rawData_ = info.rawStream;
+        bytesPerLine_ = stride;
+        return true;
+    }
+
 private:
     std::basic_streambuf<char>* rawData_;
     size_t bytesPerPixel_;
@@ -235,20 +280,60 @@ void TransformTripletToLine(const Triplet<T>* byteInput, const int32_t pixelStri
 }
 
 
+// Maps a color transform to the index of its vectorized line functions in simd_functions.
+// TransformShifted (HP1, HP2 and HP3 for 9 to 15 bit samples) has no vectorized line functions and maps to std::false_type.
+template<typename TRANSFORM>
+struct VectorizedTransform : std::false_type
+{
+};
+
+template<typename T>
+struct VectorizedTransform<TransformNone<T>> : std::true_type
+{
+    static constexpr color_transformation transformation = color_transformation::none;
+};
+
+template<typename T>
+struct VectorizedTransform<TransformHp1<T>> : std::true_type
+{
+    static constexpr color_transformation transformation = color_transformation::hp1;
+};
+
+template<typename T>
+struct VectorizedTransform<TransformHp2<T>> : std::true_type
+{
+    static constexpr color_transformation transformation = color_transformation::hp2;
+};
+
+template<typename T>
+struct VectorizedTransform<TransformHp3<T>> : std::true_type
+{
+    static constexpr color_transformation transformation = color_transformation::hp3;
+};
+
+
+// Purpose: applies the color transform and (de)interleaves the samples of a line.
+// Note: pixels with 3 components of 8 or 16 bit are (de)interleaved with the vectorized functions of simd_functions.
+//       Restriction: the shifted transforms (9 to 15 bit samples), pixels with 4 components (Quad) and BGR output
+//       are not vectorized and always use the scalar code, whatever instruction set the CPU supports.
 template<typename TRANSFORM>
 class ProcessTransformed final : public ProcessLine
 {
 public:
-    ProcessTransformed(ByteStreamInfo rawStream, const uint32_t stride, const frame_info& info, const coding_parameters& parameters, TRANSFORM transform) :
+    ProcessTransformed(ByteStreamInfo rawStream, const uint32_t stride, const frame_info& info, const coding_parameters& parameters, TRANSFORM transform,
+                       const simd_functions& functions = simd_dispatch, const charls_allocator& memory_allocator = {}) :
         frame_info_{info},
         parameters_{parameters},
         stride_{stride},
-        tempLine_(static_cast<size_t>(info.width) * info.component_count),
-        buffer_(static_cast<size_t>(info.width) * info.component_count * sizeof(size_type)),
+        tempLine_(static_cast<size_t>(info.width) * info.component_count, allocator_adapter<size_type>(memory_allocator)),
+        buffer_(static_cast<size_t>(info.width) * info.component_count * sizeof(size_type), allocator_adapter<uint8_t>(memory_allocator)),
         transform_{transform},
         inverseTransform_{transform},
         rawPixels_{rawStream}
     {
+        transformLine_ = &ProcessTransformed::TransformBaseline;
+        decodeTransformLine_ = &ProcessTransformed::DecodeTransformBaseline;
+        SelectTripletLineFunctions(functions, VectorizedTransform<TRANSFORM>());
     }
 
     void NewLineRequested(void* dest, const int pixelCount, const int destStride) override
@@ -263,6 +348,13 @@ class ProcessTransformed final : public ProcessLine
         Transform(rawPixels_.rawStream, dest, pixelCount, destStride);
     }
 
+    bool Reset(const ByteStreamInfo info, const uint32_t stride) noexcept override
+    {
+        rawPixels_ = info;
+        stride_ = stride;
+        return true;
+    }
+
     void Transform(std::basic_streambuf<char>* rawStream, void* destination, const int pixelCount, const int destinationStride)
     {
         std::streamsize bytesToRead = static_cast<std::streamsize>(pixelCount) * frame_info_.component_count * sizeof(size_type);
@@ -277,7 +369,39 @@ class ProcessTransformed final : public ProcessLine
         Transform(buffer_.data(), destination, pixelCount, destinationStride);
     }
 
-    void Transform(const void* source, void* dest, int pixelCount, int destStride) noexcept
+    void Transform(const void* source, void* dest, const int pixelCount, const int destStride) noexcept
+    {
+        (this->*transformLine_)(source, dest, pixelCount, destStride);
+    }
+
+    void DecodeTransform(const void* pSrc, void* rawData, const int pixelCount, const int byteStride) noexcept
+    {
+        (this->*decodeTransformLine_)(pSrc, rawData, pixelCount, byteStride);
+    }
+
+    void NewLineDecoded(const void* pSrc, const int pixelCount, const int sourceStride) override
+    {
+        if (rawPixels_.rawStream)
+        {
+            const std::streamsize bytesToWrite = static_cast<std::streamsize>(pixelCount) * frame_info_.component_count * sizeof(size_type);
+            DecodeTransform(pSrc, buffer_.data(), pixelCount, sourceStride);
+
+            const auto bytesWritten = rawPixels_.rawStream->sputn(reinterpret_cast<char*>(buffer_.data()), bytesToWrite);
+            if (bytesWritten != bytesToWrite)
+                throw jpegls_error{jpegls_errc::destination_buffer_too_small};
+        }
+        else
+        {
+            DecodeTransform(pSrc, rawPixels_.rawData, pixelCount, sourceStride);
+            rawPixels_.rawData += stride_;
+        }
+    }
+
+private:
+    using size_type = typename TRANSFORM::size_type;
+    using LineFunction = void (ProcessTransformed::*)(const void* source, void* destination, int pixelCount, int stride);
+
+    void TransformBaseline(const void* source, void* dest, int pixelCount, int destStride) noexcept
     {
         if (parameters_.output_bgr)
         {
@@ -310,7 +434,7 @@ class ProcessTransformed final : public ProcessLine
         }
     }
 
-    void DecodeTransform(const void* pSrc, void* rawData, int pixelCount, int byteStride) noexcept
+    void DecodeTransformBaseline(const void* pSrc, void* rawData, int pixelCount, int byteStride) noexcept
     {
         if (frame_info_.component_count == 3)
         {
@@ -341,35 +465,66 @@ class ProcessTransformed final : public ProcessLine
         }
     }
 
-    void NewLineDecoded(const void* pSrc, const int pixelCount, const int sourceStride) override
+    void SelectTripletLineFunctions(const simd_functions& functions, std::true_type /*vectorized*/) noexcept
     {
-        if (rawPixels_.rawStream)
-        {
-            const std::streamsize bytesToWrite = static_cast<std::streamsize>(pixelCount) * frame_info_.component_count * sizeof(size_type);
-            DecodeTransform(pSrc, buffer_.data(), pixelCount, sourceStride);
+        if (frame_info_.component_count != 3 || parameters_.output_bgr)
+            return;
 
-            const auto bytesWritten = rawPixels_.rawStream->sputn(reinterpret_cast<char*>(buffer_.data()), bytesToWrite);
-            if (bytesWritten != bytesToWrite)
-                throw jpegls_error{jpegls_errc::destination_buffer_too_small};
+        tripletLineFunctions_ = get_triplet_line_functions<size_type>(functions, VectorizedTransform<TRANSFORM>::transformation);
+        transformLine_ = &ProcessTransformed::TransformTriplets;
+        decodeTransformLine_ = &ProcessTransformed::DecodeTransformTriplets;
+    }
+
+    static void SelectTripletLineFunctions(const simd_functions& /*functions*/, std::false_type /*vectorized*/) noexcept
+    {
+    }
+
+    // The vectorized functions convert whole vectors of every component, the remaining pixels use the scalar code.
+    void TransformTriplets(const void* source, void* dest, const int pixelCount, const int destStride) noexcept
+    {
+        const auto* sourceTriplets = static_cast<const Triplet<size_type>*>(source);
+
+        if (parameters_.interleave_mode == interleave_mode::sample)
+        {
+            const int converted = tripletLineFunctions_.transform_triplets(static_cast<const size_type*>(source), static_cast<size_type*>(dest), pixelCount);
+            TransformLine(static_cast<Triplet<size_type>*>(dest) + converted, sourceTriplets + converted, pixelCount - converted, transform_);
         }
         else
         {
-            DecodeTransform(pSrc, rawPixels_.rawData, pixelCount, sourceStride);
-            rawPixels_.rawData += stride_;
+            const int pixel_count = std::min(pixelCount, destStride);
+            const int converted = tripletLineFunctions_.triplets_to_lines(static_cast<const size_type*>(source), pixel_count, static_cast<size_type*>(dest), static_cast<size_t>(destStride));
+            TransformTripletToLine(sourceTriplets + converted, pixel_count - converted, static_cast<size_type*>(dest) + converted, destStride, transform_);
         }
     }
 
-private:
-    using size_type = typename TRANSFORM::size_type;
+    void DecodeTransformTriplets(const void* pSrc, void* rawData, const int pixelCount, const int byteStride) noexcept
+    {
+        auto* destinationTriplets = static_cast<Triplet<size_type>*>(rawData);
+
+        if (parameters_.interleave_mode == interleave_mode::sample)
+        {
+            const int converted = tripletLineFunctions_.inverse_transform_triplets(static_cast<const size_type*>(pSrc), static_cast<size_type*>(rawData), pixelCount);
+            TransformLine(destinationTriplets + converted, static_cast<const Triplet<size_type>*>(pSrc) + converted, pixelCount - converted, inverseTransform_);
+        }
+        else
+        {
+            const int pixel_count = std::min(pixelCount, byteStride);
+            const int converted = tripletLineFunctions_.lines_to_triplets(static_cast<const size_type*>(pSrc), static_cast<size_t>(byteStride), static_cast<size_type*>(rawData), pixel_count);
+            TransformLineToTriplet(static_cast<const size_type*>(pSrc) + converted, byteStride, destinationTriplets + converted, pixel_count - converted, inverseTransform_);
+        }
+    }
 
     const frame_info& frame_info_;
     const coding_parameters& parameters_;
-    const uint32_t stride_;
-    std::vector<size_type> tempLine_;
-    std::vector<uint8_t> buffer_;
+    uint32_t stride_;
+    allocated_vector<size_type> tempLine_;
+    allocated_vector<uint8_t> buffer_;
     TRANSFORM transform_;
     typename TRANSFORM::Inverse inverseTransform_;
     ByteStreamInfo rawPixels_;
+    LineFunction transformLine_{};
+    LineFunction decodeTransformLine_{};
+    triplet_line_functions<size_type> tripletLineFunctions_{};
 };
 
 } // namespace charls
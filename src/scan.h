@@ -9,8 +9,10 @@
 #include "context_run_mode.h"
 #include "lookup_table.h"
 #include "process_line.h"
+#include "simd.h"
 
 #include <array>
+#include <limits>
 #include <sstream>
 
 // This file contains the code for handling a "scan". Usually an image is encoded as a single scan.
@@ -20,11 +22,43 @@ namespace charls {
 class DecoderStrategy;
 class EncoderStrategy;
 
-extern std::array<CTable, 16> decodingTables;
+extern std::array<CTable<8>, 16> decodingTables;
+extern std::array<CTable<12>, 16> decodingTables12;
+
+// Purpose: returns the tables to decode short Golomb codes (one for each value of k).
+//          8 bit samples use 8 bit tables, which stay in the L1 cache. Larger samples have larger values of k
+//          and longer codes: 12 bit tables decode most of these codes without the slow DecodeValue path.
+template<typename Sample>
+struct golomb_code_tables;
+
+template<>
+struct golomb_code_tables<uint8_t> final
+{
+    static constexpr int32_t lookup_bit_count = 8;
+
+    static const std::array<CTable<8>, 16>& get() noexcept
+    {
+        return decodingTables;
+    }
+};
+
+template<>
+struct golomb_code_tables<uint16_t> final
+{
+    static constexpr int32_t lookup_bit_count = 12;
+
+    static const std::array<CTable<12>, 16>& get() noexcept
+    {
+        return decodingTables12;
+    }
+};
 extern std::vector<signed char> rgquant8Ll;
 extern std::vector<signed char> rgquant10Ll;
 extern std::vector<signed char> rgquant12Ll;
 extern std::vector<signed char> rgquant16Ll;
+#ifdef USE_COMBINED_CONTEXT_LUT
+extern std::vector<int16_t> rgcontext8Ll;
+#endif
 
 constexpr int32_t ApplySign(const int32_t i, const int32_t sign) noexcept
 {
@@ -106,10 +140,14 @@ class JlsCodec final : public Strategy
     using PIXEL = typename Traits::PIXEL;
     using SAMPLE = typename Traits::SAMPLE;
 
-    JlsCodec(Traits inTraits, const frame_info& frame_info, const coding_parameters& parameters) :
-        Strategy{update_component_count(frame_info, parameters), parameters},
+    JlsCodec(Traits inTraits, const frame_info& frame_info, const coding_parameters& parameters, const charls_allocator& memory_allocator) :
+        Strategy{update_component_count(frame_info, parameters), parameters, memory_allocator},
         traits{std::move(inTraits)},
-        width_{frame_info.width}
+        width_{frame_info.width},
+        lineBuffer_(allocator_adapter<PIXEL>(memory_allocator)),
+        runIndexes_(allocator_adapter<int32_t>(memory_allocator)),
+        sourceLine_(allocator_adapter<PIXEL>(memory_allocator)),
+        rgquant_(allocator_adapter<signed char>(memory_allocator))
     {
         ASSERT((parameters.interleave_mode == interleave_mode::none && this->frame_info().component_count == 1) || parameters.interleave_mode != interleave_mode::none);
     }
@@ -124,7 +162,7 @@ class JlsCodec final : public Strategy
                    presets.reset_value != 0 ? presets.reset_value : presetDefault.reset_value);
     }
 
-    std::unique_ptr<ProcessLine> CreateProcess(ByteStreamInfo info, uint32_t stride) override;
+    allocated_ptr<ProcessLine> CreateProcess(ByteStreamInfo info, uint32_t stride) override;
 
     bool IsInterleaved() noexcept
     {
@@ -151,6 +189,21 @@ class JlsCodec final : public Strategy
         return *(pquant_ + Di);
     }
 
+    // Computes the context ID of the gradients D1, D2 and D3. ITU.T.87, A.3.3 and A.3.4 (without the sign fold)
+    FORCE_INLINE int32_t GetContextID(const int32_t D1, const int32_t D2, const int32_t D3) const noexcept
+    {
+#ifdef USE_COMBINED_CONTEXT_LUT
+        if (pcontext_)
+        {
+            const int32_t Q12 = pcontext_[std::min(std::max(D1, -T3), T3) * (2 * T3 + 1) + std::min(std::max(D2, -T3), T3)];
+            ASSERT(Q12 == ComputeContextID(QuantizeGradient(D1), QuantizeGradient(D2), 0));
+            return Q12 + QuantizeGradient(D3);
+        }
+#endif
+
+        return ComputeContextID(QuantizeGradient(D1), QuantizeGradient(D2), QuantizeGradient(D3));
+    }
+
     void InitQuantizationLUT();
 
     int32_t DecodeValue(int32_t k, int32_t limit, int32_t qbpp);
@@ -171,14 +224,17 @@ class JlsCodec final : public Strategy
     Quad<SAMPLE> DecodeRIPixel(Quad<SAMPLE> Ra, Quad<SAMPLE> Rb);
     SAMPLE DecodeRIPixel(int32_t Ra, int32_t Rb);
     int32_t DecodeRunPixels(PIXEL Ra, PIXEL* startPos, int32_t cpixelMac);
-    int32_t DoRunMode(int32_t startIndex, DecoderStrategy*);
+    int32_t DoRunMode(int32_t startIndex, PIXEL Ra, DecoderStrategy*);
 
     void EncodeRIError(CContextRunMode& ctx, int32_t errorValue);
     SAMPLE EncodeRIPixel(int32_t x, int32_t Ra, int32_t Rb);
     Triplet<SAMPLE> EncodeRIPixel(Triplet<SAMPLE> x, Triplet<SAMPLE> Ra, Triplet<SAMPLE> Rb);
     Quad<SAMPLE> EncodeRIPixel(Quad<SAMPLE> x, Quad<SAMPLE> Ra, Quad<SAMPLE> Rb);
     void EncodeRunPixels(int32_t runLength, bool endOfLine);
-    int32_t DoRunMode(int32_t index, EncoderStrategy*);
+    int32_t DetectRunLength(SAMPLE* startPos, int32_t cpixelMac, SAMPLE Ra);
+    template<typename Pixel>
+    int32_t DetectRunLength(Pixel* startPos, int32_t cpixelMac, Pixel Ra);
+    int32_t DoRunMode(int32_t index, PIXEL Ra, EncoderStrategy*);
 
     FORCE_INLINE SAMPLE DoRegular(int32_t Qs, int32_t, int32_t pred, DecoderStrategy*);
     FORCE_INLINE SAMPLE DoRegular(int32_t Qs, int32_t x, int32_t pred, EncoderStrategy*);
@@ -186,9 +242,35 @@ class JlsCodec final : public Strategy
     void DoLine(SAMPLE* dummy);
     void DoLine(Triplet<SAMPLE>* dummy);
     void DoLine(Quad<SAMPLE>* dummy);
+    void DoLineInPlace(int32_t firstRc);
+    int32_t DoRunModeInPlace(int32_t startIndex, PIXEL Ra, DecoderStrategy*);
+    int32_t DoRunModeInPlace(int32_t index, PIXEL Ra, EncoderStrategy*);
+
+    FORCE_INLINE void StoreInPlace(const int32_t index, const SAMPLE value, DecoderStrategy*) noexcept
+    {
+        currentLine_[index] = value;
+    }
+
+    FORCE_INLINE static void StoreInPlace(int32_t /*index*/, SAMPLE /*value*/, EncoderStrategy*) noexcept
+    {
+        // The source samples are read in place and are not modified, lossless coding reconstructs them exactly.
+    }
+    void DoComponentLine(int32_t component, DecoderStrategy*);
+    void DoComponentLine(int32_t component, EncoderStrategy*);
     void DoScan();
+    void DoScanInPlace(uint8_t* lines, size_t stride);
+    bool CanCodeInPlace(DecoderStrategy*) const noexcept;
+    bool CanCodeInPlace(EncoderStrategy*) const noexcept;
+    bool TryDoScanInPlace(SAMPLE*);
+
+    template<typename Pixel>
+    static bool TryDoScanInPlace(Pixel*) noexcept
+    {
+        return false; // Only lines of single samples are coded in place.
+    }
 
     void InitParams(int32_t t1, int32_t t2, int32_t t3, int32_t nReset);
+    void ResetParams() noexcept;
 
 #if defined(__clang__)
 #pragma clang diagnostic push
@@ -197,10 +279,10 @@ class JlsCodec final : public Strategy
 
     // Note: depending on the base class EncodeScan OR DecodeScan will be virtual and abstract, cannot use override in all cases.
     // NOLINTNEXTLINE(cppcoreguidelines-explicit-virtual-functions, hicpp-use-override, modernize-use-override)
-    size_t EncodeScan(std::unique_ptr<ProcessLine> processLine, ByteStreamInfo& compressedData);
+    size_t EncodeScan(allocated_ptr<ProcessLine> processLine, ByteStreamInfo& compressedData);
 
     // NOLINTNEXTLINE(cppcoreguidelines-explicit-virtual-functions, hicpp-use-override, modernize-use-override)
-    void DecodeScan(std::unique_ptr<ProcessLine> processLine, const JlsRect& rect, ByteStreamInfo& compressedData);
+    void DecodeScan(allocated_ptr<ProcessLine> processLine, const JlsRect& rect, ByteStreamInfo& compressedData);
 
 #if defined(__clang__)
 #pragma clang diagnostic pop
@@ -224,6 +306,7 @@ class JlsCodec final : public Strategy
     int32_t T1{};
     int32_t T2{};
     int32_t T3{};
+    int32_t nReset_{};
 
     // compression context
     std::array<JlsContext, 365> contexts_;
@@ -232,9 +315,22 @@ class JlsCodec final : public Strategy
     PIXEL* previousLine_{};
     PIXEL* currentLine_{};
 
+    // line buffers and run indexes of DoScan, kept to code the next scan of a reused codec without allocations.
+    allocated_vector<PIXEL> lineBuffer_;
+    allocated_vector<int32_t> runIndexes_;
+
+    // copy of the source samples of the current line, only used when the encoder collects error metrics.
+    allocated_vector<PIXEL> sourceLine_;
+
     // quantization lookup table
     signed char* pquant_{};
-    std::vector<signed char> rgquant_;
+    allocated_vector<signed char> rgquant_;
+
+#ifdef USE_COMBINED_CONTEXT_LUT
+    // Context lookup table for the first two gradients (8 bit lossless with the default thresholds).
+    // Disabled by default: 3 lookups in the 512 byte quantization table are faster than the clamps and the 3.6 KB table.
+    const int16_t* pcontext_{};
+#endif
 };
 
 
@@ -248,7 +344,8 @@ typename Traits::SAMPLE JlsCodec<Traits, Strategy>::DoRegular(const int32_t Qs,
     const int32_t Px = traits.CorrectPrediction(pred + ApplySign(ctx.C, sign));
 
     int32_t ErrVal;
-    const Code& code = decodingTables[k].Get(Strategy::PeekByte());
+    using tables = golomb_code_tables<SAMPLE>;
+    const Code& code = tables::get()[k].Get(Strategy::template PeekBits<tables::lookup_bit_count>());
     if (code.GetLength() != 0)
     {
         Strategy::Skip(code.GetLength());
@@ -296,19 +393,20 @@ inline std::pair<int32_t, int32_t> CreateEncodedValue(const int32_t k, const int
 }
 
 
-inline CTable InitTable(const int32_t k) noexcept
+template<size_t LookupBitCount>
+CTable<LookupBitCount> InitTable(const int32_t k) noexcept
 {
-    CTable table;
+    CTable<LookupBitCount> table;
     for (short nerr = 0;; ++nerr)
     {
         // Q is not used when k != 0
         const int32_t merrval = GetMappedErrVal(nerr);
         const std::pair<int32_t, int32_t> pairCode = CreateEncodedValue(k, merrval);
-        if (static_cast<size_t>(pairCode.first) > CTable::byte_bit_count)
+        if (static_cast<size_t>(pairCode.first) > LookupBitCount)
             break;
 
         const Code code(nerr, static_cast<short>(pairCode.first));
-        table.AddEntry(static_cast<uint8_t>(pairCode.second), code);
+        table.AddEntry(static_cast<uint32_t>(pairCode.second), code);
     }
 
     for (short nerr = -1;; --nerr)
@@ -316,11 +414,11 @@ inline CTable InitTable(const int32_t k) noexcept
         // Q is not used when k != 0
         const int32_t merrval = GetMappedErrVal(nerr);
         const std::pair<int32_t, int32_t> pairCode = CreateEncodedValue(k, merrval);
-        if (static_cast<size_t>(pairCode.first) > CTable::byte_bit_count)
+        if (static_cast<size_t>(pairCode.first) > LookupBitCount)
             break;
 
         const Code code = Code(nerr, static_cast<short>(pairCode.first));
-        table.AddEntry(static_cast<uint8_t>(pairCode.second), code);
+        table.AddEntry(static_cast<uint32_t>(pairCode.second), code);
     }
 
     return table;
@@ -393,6 +491,9 @@ void JlsCodec<Traits, Strategy>::InitQuantizationLUT()
             if (traits.bpp == 8)
             {
                 pquant_ = &rgquant8Ll[rgquant8Ll.size() / 2];
+#ifdef USE_COMBINED_CONTEXT_LUT
+                pcontext_ = &rgcontext8Ll[rgcontext8Ll.size() / 2];
+#endif
                 return;
             }
             if (traits.bpp == 10)
@@ -595,6 +696,27 @@ template<typename Traits, typename Strategy>
 int32_t JlsCodec<Traits, Strategy>::DecodeRunPixels(PIXEL Ra, PIXEL* startPos, const int32_t cpixelMac)
 {
     int32_t index = 0;
+
+    // Consume all the 1 bits (completed run segments) in the bit cache in one step, as long as they don't reach the end of the line.
+    for (;;)
+    {
+        const int32_t segmentCount = Strategy::PeekLeadingOnes();
+        if (segmentCount == 0)
+            break;
+
+        const int32_t runIndexEnd = RUNindex_ + segmentCount;
+        const int32_t runLength = runIndexEnd <= 31
+                                      ? JRunLengthSum[runIndexEnd] - JRunLengthSum[RUNindex_]
+                                      : JRunLengthSum[31] - JRunLengthSum[RUNindex_] + (runIndexEnd - 31) * (1 << J[31]);
+        if (runLength >= cpixelMac - index)
+            break;
+
+        index += runLength;
+        RUNindex_ = std::min(31, runIndexEnd);
+        Strategy::Skip(segmentCount);
+    }
+
+    // Handle the segment that reaches the end of the line and the 0 bit that ends an incomplete run.
     while (Strategy::ReadBit())
     {
         const int count = std::min(1 << J[RUNindex_], static_cast<int>(cpixelMac - index));
@@ -619,34 +741,48 @@ int32_t JlsCodec<Traits, Strategy>::DecodeRunPixels(PIXEL Ra, PIXEL* startPos, c
     if (index > cpixelMac)
         impl::throw_jpegls_error(jpegls_errc::invalid_encoded_data);
 
-    for (int32_t i = 0; i < index; ++i)
-    {
-        startPos[i] = Ra;
-    }
-
+    fill_n_values(startPos, static_cast<size_t>(index), Ra);
     return index;
 }
 
 template<typename Traits, typename Strategy>
-int32_t JlsCodec<Traits, Strategy>::DoRunMode(int32_t index, EncoderStrategy*)
+int32_t JlsCodec<Traits, Strategy>::DetectRunLength(SAMPLE* startPos, const int32_t cpixelMac, const SAMPLE Ra)
 {
-    const int32_t ctypeRem = width_ - index;
-    PIXEL* ptypeCurX = currentLine_ + index;
-    const PIXEL* ptypePrevX = previousLine_ + index;
+    // Lossless: IsNear is an equality test and the samples of the run are already equal to Ra: compare many samples per step.
+    if (traits.NEAR == 0)
+        return static_cast<int32_t>(count_equal_values(startPos, static_cast<size_t>(cpixelMac), Ra));
+
+    return DetectRunLength<SAMPLE>(startPos, cpixelMac, Ra);
+}
 
-    const PIXEL Ra = ptypeCurX[-1];
 
+template<typename Traits, typename Strategy>
+template<typename Pixel>
+int32_t JlsCodec<Traits, Strategy>::DetectRunLength(Pixel* startPos, const int32_t cpixelMac, const Pixel Ra)
+{
     int32_t runLength = 0;
 
-    while (traits.IsNear(ptypeCurX[runLength], Ra))
+    while (traits.IsNear(startPos[runLength], Ra))
     {
-        ptypeCurX[runLength] = Ra;
+        startPos[runLength] = Ra;
         ++runLength;
 
-        if (runLength == ctypeRem)
+        if (runLength == cpixelMac)
             break;
     }
 
+    return runLength;
+}
+
+
+template<typename Traits, typename Strategy>
+int32_t JlsCodec<Traits, Strategy>::DoRunMode(int32_t index, const PIXEL Ra, EncoderStrategy*)
+{
+    const int32_t ctypeRem = width_ - index;
+    PIXEL* ptypeCurX = currentLine_ + index;
+    const PIXEL* ptypePrevX = previousLine_ + index;
+
+    const int32_t runLength = DetectRunLength(ptypeCurX, ctypeRem, Ra);
     EncodeRunPixels(runLength, runLength == ctypeRem);
 
     if (runLength == ctypeRem)
@@ -659,10 +795,8 @@ int32_t JlsCodec<Traits, Strategy>::DoRunMode(int32_t index, EncoderStrategy*)
 
 
 template<typename Traits, typename Strategy>
-int32_t JlsCodec<Traits, Strategy>::DoRunMode(int32_t startIndex, DecoderStrategy*)
+int32_t JlsCodec<Traits, Strategy>::DoRunMode(int32_t startIndex, const PIXEL Ra, DecoderStrategy*)
 {
-    const PIXEL Ra = currentLine_[startIndex - 1];
-
     const int32_t runLength = DecodeRunPixels(Ra, currentLine_ + startIndex, width_ - startIndex);
     const uint32_t endIndex = startIndex + runLength;
 
@@ -692,7 +826,7 @@ void JlsCodec<Traits, Strategy>::DoLine(SAMPLE*)
         Rb = Rd;
         Rd = previousLine_[index + 1];
 
-        const int32_t Qs = ComputeContextID(QuantizeGradient(Rd - Rb), QuantizeGradient(Rb - Rc), QuantizeGradient(Rc - Ra));
+        const int32_t Qs = GetContextID(Rd - Rb, Rb - Rc, Rc - Ra);
 
         if (Qs != 0)
         {
@@ -701,7 +835,7 @@ void JlsCodec<Traits, Strategy>::DoLine(SAMPLE*)
         }
         else
         {
-            index += DoRunMode(index, static_cast<Strategy*>(nullptr));
+            index += DoRunMode(index, static_cast<PIXEL>(Ra), static_cast<Strategy*>(nullptr));
             Rb = previousLine_[index - 1];
             Rd = previousLine_[index];
         }
@@ -709,6 +843,72 @@ void JlsCodec<Traits, Strategy>::DoLine(SAMPLE*)
 }
 
 
+/// <summary>Encodes/Decodes a scan line of samples in place in the buffer of the caller</summary>
+/// <remarks>
+/// The lines have no padding: the edge pixels are not read from the line buffers like DoLine does.
+/// Rc of the first sample is passed by the caller and Rd of the last sample is the last sample of the previous line.
+/// </remarks>
+template<typename Traits, typename Strategy>
+void JlsCodec<Traits, Strategy>::DoLineInPlace(const int32_t firstRc)
+{
+    const int32_t lastIndex = static_cast<int32_t>(width_) - 1;
+    int32_t index = 0;
+    int32_t Ra = previousLine_[0];
+    int32_t Rb = firstRc;
+    int32_t Rd = previousLine_[0];
+
+    while (static_cast<uint32_t>(index) < width_)
+    {
+        const int32_t Rc = Rb;
+        Rb = Rd;
+        Rd = previousLine_[std::min(index + 1, lastIndex)];
+
+        const int32_t Qs = GetContextID(Rd - Rb, Rb - Rc, Rc - Ra);
+
+        if (Qs != 0)
+        {
+            Ra = DoRegular(Qs, currentLine_[index], GetPredictedValue(Ra, Rb, Rc), static_cast<Strategy*>(nullptr));
+            StoreInPlace(index, static_cast<SAMPLE>(Ra), static_cast<Strategy*>(nullptr));
+            ++index;
+        }
+        else
+        {
+            index += DoRunModeInPlace(index, static_cast<PIXEL>(Ra), static_cast<Strategy*>(nullptr));
+            if (static_cast<uint32_t>(index) == width_)
+                break;
+
+            Ra = currentLine_[index - 1];
+            Rb = previousLine_[index - 1];
+            Rd = previousLine_[index];
+        }
+    }
+}
+
+
+template<typename Traits, typename Strategy>
+int32_t JlsCodec<Traits, Strategy>::DoRunModeInPlace(const int32_t startIndex, const PIXEL Ra, DecoderStrategy*)
+{
+    return DoRunMode(startIndex, Ra, static_cast<DecoderStrategy*>(nullptr));
+}
+
+
+// Same as DoRunMode but the interruption sample is not stored: the source line can't be modified.
+template<typename Traits, typename Strategy>
+int32_t JlsCodec<Traits, Strategy>::DoRunModeInPlace(const int32_t index, const PIXEL Ra, EncoderStrategy*)
+{
+    const int32_t ctypeRem = width_ - index;
+    const int32_t runLength = DetectRunLength(currentLine_ + index, ctypeRem, Ra);
+    EncodeRunPixels(runLength, runLength == ctypeRem);
+
+    if (runLength == ctypeRem)
+        return runLength;
+
+    EncodeRIPixel(currentLine_[index + runLength], Ra, previousLine_[index + runLength]);
+    DecrementRunIndex();
+    return runLength + 1;
+}
+
+
 /// <summary>Encodes/Decodes a scan line of triplets in ILV_SAMPLE mode</summary>
 template<typename Traits, typename Strategy>
 void JlsCodec<Traits, Strategy>::DoLine(Triplet<SAMPLE>*)
@@ -721,13 +921,13 @@ void JlsCodec<Traits, Strategy>::DoLine(Triplet<SAMPLE>*)
         const Triplet<SAMPLE> Rb = previousLine_[index];
         const Triplet<SAMPLE> Rd = previousLine_[index + 1];
 
-        const int32_t Qs1 = ComputeContextID(QuantizeGradient(Rd.v1 - Rb.v1), QuantizeGradient(Rb.v1 - Rc.v1), QuantizeGradient(Rc.v1 - Ra.v1));
-        const int32_t Qs2 = ComputeContextID(QuantizeGradient(Rd.v2 - Rb.v2), QuantizeGradient(Rb.v2 - Rc.v2), QuantizeGradient(Rc.v2 - Ra.v2));
-        const int32_t Qs3 = ComputeContextID(QuantizeGradient(Rd.v3 - Rb.v3), QuantizeGradient(Rb.v3 - Rc.v3), QuantizeGradient(Rc.v3 - Ra.v3));
+        const int32_t Qs1 = GetContextID(Rd.v1 - Rb.v1, Rb.v1 - Rc.v1, Rc.v1 - Ra.v1);
+        const int32_t Qs2 = GetContextID(Rd.v2 - Rb.v2, Rb.v2 - Rc.v2, Rc.v2 - Ra.v2);
+        const int32_t Qs3 = GetContextID(Rd.v3 - Rb.v3, Rb.v3 - Rc.v3, Rc.v3 - Ra.v3);
 
         if (Qs1 == 0 && Qs2 == 0 && Qs3 == 0)
         {
-            index += DoRunMode(index, static_cast<Strategy*>(nullptr));
+            index += DoRunMode(index, Ra, static_cast<Strategy*>(nullptr));
         }
         else
         {
@@ -754,14 +954,14 @@ void JlsCodec<Traits, Strategy>::DoLine(Quad<SAMPLE>*)
         const Quad<SAMPLE> Rb = previousLine_[index];
         const Quad<SAMPLE> Rd = previousLine_[index + 1];
 
-        const int32_t Qs1 = ComputeContextID(QuantizeGradient(Rd.v1 - Rb.v1), QuantizeGradient(Rb.v1 - Rc.v1), QuantizeGradient(Rc.v1 - Ra.v1));
-        const int32_t Qs2 = ComputeContextID(QuantizeGradient(Rd.v2 - Rb.v2), QuantizeGradient(Rb.v2 - Rc.v2), QuantizeGradient(Rc.v2 - Ra.v2));
-        const int32_t Qs3 = ComputeContextID(QuantizeGradient(Rd.v3 - Rb.v3), QuantizeGradient(Rb.v3 - Rc.v3), QuantizeGradient(Rc.v3 - Ra.v3));
-        const int32_t Qs4 = ComputeContextID(QuantizeGradient(Rd.v4 - Rb.v4), QuantizeGradient(Rb.v4 - Rc.v4), QuantizeGradient(Rc.v4 - Ra.v4));
+        const int32_t Qs1 = GetContextID(Rd.v1 - Rb.v1, Rb.v1 - Rc.v1, Rc.v1 - Ra.v1);
+        const int32_t Qs2 = GetContextID(Rd.v2 - Rb.v2, Rb.v2 - Rc.v2, Rc.v2 - Ra.v2);
+        const int32_t Qs3 = GetContextID(Rd.v3 - Rb.v3, Rb.v3 - Rc.v3, Rc.v3 - Ra.v3);
+        const int32_t Qs4 = GetContextID(Rd.v4 - Rb.v4, Rb.v4 - Rc.v4, Rc.v4 - Ra.v4);
 
         if (Qs1 == 0 && Qs2 == 0 && Qs3 == 0 && Qs4 == 0)
         {
-            index += DoRunMode(index, static_cast<Strategy*>(nullptr));
+            index += DoRunMode(index, Ra, static_cast<Strategy*>(nullptr));
         }
         else
         {
@@ -777,6 +977,30 @@ void JlsCodec<Traits, Strategy>::DoLine(Quad<SAMPLE>*)
 }
 
 
+template<typename Traits, typename Strategy>
+void JlsCodec<Traits, Strategy>::DoComponentLine(int32_t, DecoderStrategy*)
+{
+    DoLine(static_cast<PIXEL*>(nullptr));
+}
+
+
+// Encodes a line of a component. When requested, the source samples are compared with the reconstructed samples
+// (what the decoder will produce) after the line has been encoded: the sample coding loops don't need extra work.
+template<typename Traits, typename Strategy>
+void JlsCodec<Traits, Strategy>::DoComponentLine(const int32_t component, EncoderStrategy*)
+{
+    if (!Strategy::errorMetrics_)
+    {
+        DoLine(static_cast<PIXEL*>(nullptr));
+        return;
+    }
+
+    sourceLine_.assign(currentLine_, currentLine_ + width_);
+    DoLine(static_cast<PIXEL*>(nullptr));
+    Strategy::errorMetrics_->add_line(Strategy::firstComponent_ + component, sourceLine_.data(), currentLine_, width_);
+}
+
+
 // DoScan: Encodes or decodes a scan.
 // In ILV_SAMPLE mode, multiple components are handled in DoLine
 // In ILV_LINE mode, a call do DoLine is made for every component
@@ -788,13 +1012,28 @@ void JlsCodec<Traits, Strategy>::DoScan()
     const int32_t pixelStride = width_ + 4;
     const int components = parameters().interleave_mode == interleave_mode::line ? frame_info().component_count : 1;
 
-    std::vector<PIXEL> vectmp(static_cast<size_t>(2) * components * pixelStride);
-    std::vector<int32_t> rgRUNindex(components);
+    lineBuffer_.assign(static_cast<size_t>(2) * components * pixelStride, PIXEL{});
+    runIndexes_.assign(components, 0);
+
+    const uint32_t restartInterval = parameters().restart_interval;
+    int32_t restartMarkerIndex{Strategy::firstRestartMarkerIndex_};
 
     for (uint32_t line = 0; line < frame_info().height; ++line)
     {
-        previousLine_ = &vectmp[1];
-        currentLine_ = &vectmp[1 + static_cast<size_t>(components) * pixelStride];
+        if (restartInterval != 0 && line != 0 && line % restartInterval == 0)
+        {
+            // A restart interval is coded as if it is the start of the scan: the coding state is reset
+            // and the line before the first line of the interval is treated as all zero (see ISO/IEC 14495-1, A.2.1).
+            Strategy::OnRestartMarker(restartMarkerIndex);
+            restartMarkerIndex = (restartMarkerIndex + 1) % JpegRestartMarkerRange;
+
+            ResetParams();
+            std::fill(lineBuffer_.begin(), lineBuffer_.end(), PIXEL{});
+            std::fill(runIndexes_.begin(), runIndexes_.end(), 0);
+        }
+
+        previousLine_ = &lineBuffer_[1];
+        currentLine_ = &lineBuffer_[1 + static_cast<size_t>(components) * pixelStride];
         if ((line & 1) == 1)
         {
             std::swap(previousLine_, currentLine_);
@@ -804,14 +1043,14 @@ void JlsCodec<Traits, Strategy>::DoScan()
 
         for (int component = 0; component < components; ++component)
         {
-            RUNindex_ = rgRUNindex[component];
+            RUNindex_ = runIndexes_[component];
 
             // initialize edge pixels used for prediction
             previousLine_[width_] = previousLine_[width_ - 1];
             currentLine_[-1] = previousLine_[0];
-            DoLine(static_cast<PIXEL*>(nullptr)); // dummy argument for overload resolution
+            DoComponentLine(component, static_cast<Strategy*>(nullptr)); // dummy argument for overload resolution
 
-            rgRUNindex[component] = RUNindex_;
+            runIndexes_[component] = RUNindex_;
             previousLine_ += pixelStride;
             currentLine_ += pixelStride;
         }
@@ -826,28 +1065,106 @@ void JlsCodec<Traits, Strategy>::DoScan()
 }
 
 
+// Encodes or decodes a scan of single samples directly in the lines of the caller's buffer, without copying them
+// to and from the line buffers of DoScan.
+template<typename Traits, typename Strategy>
+void JlsCodec<Traits, Strategy>::DoScanInPlace(uint8_t* lines, const size_t stride)
+{
+    // The line before the first line of the scan and of every restart interval is all zero (see ISO/IEC 14495-1, A.2.1).
+    lineBuffer_.assign(width_, PIXEL{});
+    previousLine_ = lineBuffer_.data();
+    int32_t firstRc{};
+
+    const uint32_t restartInterval = parameters().restart_interval;
+    int32_t restartMarkerIndex{Strategy::firstRestartMarkerIndex_};
+
+    for (uint32_t line = 0; line < frame_info().height; ++line, lines += stride)
+    {
+        if (restartInterval != 0 && line != 0 && line % restartInterval == 0)
+        {
+            Strategy::OnRestartMarker(restartMarkerIndex);
+            restartMarkerIndex = (restartMarkerIndex + 1) % JpegRestartMarkerRange;
+
+            ResetParams();
+            previousLine_ = lineBuffer_.data();
+            firstRc = 0;
+        }
+
+        currentLine_ = reinterpret_cast<PIXEL*>(lines);
+        DoLineInPlace(firstRc);
+
+        // Rc of the first sample of the next line is Ra of the first sample of this line.
+        firstRc = previousLine_[0];
+        previousLine_ = currentLine_;
+    }
+
+    Strategy::EndScan();
+}
+
+
+// Only complete images are decoded in place, for a part of the image DoScan decodes the lines that are not copied.
+template<typename Traits, typename Strategy>
+bool JlsCodec<Traits, Strategy>::CanCodeInPlace(DecoderStrategy*) const noexcept
+{
+    return rect_.X == 0 && rect_.Y == 0 && static_cast<uint32_t>(rect_.Width) == width_ &&
+           static_cast<uint32_t>(rect_.Height) == frame_info().height;
+}
+
+
+// The encoder doesn't modify the source samples when every sample is reconstructed exactly: lossless coding and
+// every value of the sample type is in range (out of range values are masked). The error metrics need a copy of the line.
+template<typename Traits, typename Strategy>
+bool JlsCodec<Traits, Strategy>::CanCodeInPlace(EncoderStrategy*) const noexcept
+{
+    return traits.NEAR == 0 && traits.MAXVAL == std::numeric_limits<SAMPLE>::max() && !Strategy::errorMetrics_;
+}
+
+
+// Codes the scan in place when the ProcessLine object stores the lines unconverted in a buffer that can be
+// accessed as samples. Returns false when the scan must be coded by DoScan.
+template<typename Traits, typename Strategy>
+bool JlsCodec<Traits, Strategy>::TryDoScanInPlace(SAMPLE*)
+{
+    if (!CanCodeInPlace(static_cast<Strategy*>(nullptr)))
+        return false;
+
+    size_t stride{};
+    uint8_t* lines = Strategy::processLine_->InPlaceLines(stride);
+    if (!lines || stride < width_ * sizeof(SAMPLE) || stride % alignof(SAMPLE) != 0 ||
+        reinterpret_cast<uintptr_t>(lines) % alignof(SAMPLE) != 0)
+        return false;
+
+    DoScanInPlace(lines, stride);
+    return true;
+}
+
+
 // Factory function for ProcessLine objects to copy/transform un encoded pixels to/from our scan line buffers.
 template<typename Traits, typename Strategy>
-std::unique_ptr<ProcessLine> JlsCodec<Traits, Strategy>::CreateProcess(ByteStreamInfo info, const uint32_t stride)
+allocated_ptr<ProcessLine> JlsCodec<Traits, Strategy>::CreateProcess(ByteStreamInfo info, const uint32_t stride)
 {
+    // A reused codec still owns the object of its last scan, with its line buffers.
+    if (Strategy::processLine_ && Strategy::processLine_->Reset(info, stride))
+        return std::move(Strategy::processLine_);
+
     if (!IsInterleaved())
     {
-        return info.rawData ? std::unique_ptr<ProcessLine>(std::make_unique<PostProcessSingleComponent>(info.rawData, stride, sizeof(typename Traits::PIXEL))) : std::unique_ptr<ProcessLine>(std::make_unique<PostProcessSingleStream>(info.rawStream, stride, sizeof(typename Traits::PIXEL)));
+        return info.rawData ? allocated_ptr<ProcessLine>(allocate_unique<PostProcessSingleComponent>(Strategy::allocator_, info.rawData, stride, sizeof(typename Traits::PIXEL))) : allocated_ptr<ProcessLine>(allocate_unique<PostProcessSingleStream>(Strategy::allocator_, info.rawStream, stride, sizeof(typename Traits::PIXEL)));
     }
 
     if (parameters().transformation == color_transformation::none)
-        return std::make_unique<ProcessTransformed<TransformNone<typename Traits::SAMPLE>>>(info, stride, frame_info(), parameters(), TransformNone<SAMPLE>());
+        return allocate_unique<ProcessTransformed<TransformNone<typename Traits::SAMPLE>>>(Strategy::allocator_, info, stride, frame_info(), parameters(), TransformNone<SAMPLE>(), simd_dispatch, Strategy::allocator_);
 
     if (frame_info().bits_per_sample == sizeof(SAMPLE) * 8)
     {
         switch (parameters().transformation)
         {
         case color_transformation::hp1:
-            return std::make_unique<ProcessTransformed<TransformHp1<SAMPLE>>>(info, stride, frame_info(), parameters(), TransformHp1<SAMPLE>());
+            return allocate_unique<ProcessTransformed<TransformHp1<SAMPLE>>>(Strategy::allocator_, info, stride, frame_info(), parameters(), TransformHp1<SAMPLE>(), simd_dispatch, Strategy::allocator_);
         case color_transformation::hp2:
-            return std::make_unique<ProcessTransformed<TransformHp2<SAMPLE>>>(info, stride, frame_info(), parameters(), TransformHp2<SAMPLE>());
+            return allocate_unique<ProcessTransformed<TransformHp2<SAMPLE>>>(Strategy::allocator_, info, stride, frame_info(), parameters(), TransformHp2<SAMPLE>(), simd_dispatch, Strategy::allocator_);
         case color_transformation::hp3:
-            return std::make_unique<ProcessTransformed<TransformHp3<SAMPLE>>>(info, stride, frame_info(), parameters(), TransformHp3<SAMPLE>());
+            return allocate_unique<ProcessTransformed<TransformHp3<SAMPLE>>>(Strategy::allocator_, info, stride, frame_info(), parameters(), TransformHp3<SAMPLE>(), simd_dispatch, Strategy::allocator_);
         default:
             impl::throw_jpegls_error(jpegls_errc::color_transform_not_supported);
         }
@@ -859,11 +1176,11 @@ std::unique_ptr<ProcessLine> JlsCodec<Traits, Strategy>::CreateProcess(ByteStrea
         switch (parameters().transformation)
         {
         case color_transformation::hp1:
-            return std::make_unique<ProcessTransformed<TransformShifted<TransformHp1<uint16_t>>>>(info, stride, frame_info(), parameters(), TransformShifted<TransformHp1<uint16_t>>(shift));
+            return allocate_unique<ProcessTransformed<TransformShifted<TransformHp1<uint16_t>>>>(Strategy::allocator_, info, stride, frame_info(), parameters(), TransformShifted<TransformHp1<uint16_t>>(shift), simd_dispatch, Strategy::allocator_);
         case color_transformation::hp2:
-            return std::make_unique<ProcessTransformed<TransformShifted<TransformHp2<uint16_t>>>>(info, stride, frame_info(), parameters(), TransformShifted<TransformHp2<uint16_t>>(shift));
+            return allocate_unique<ProcessTransformed<TransformShifted<TransformHp2<uint16_t>>>>(Strategy::allocator_, info, stride, frame_info(), parameters(), TransformShifted<TransformHp2<uint16_t>>(shift), simd_dispatch, Strategy::allocator_);
         case color_transformation::hp3:
-            return std::make_unique<ProcessTransformed<TransformShifted<TransformHp3<uint16_t>>>>(info, stride, frame_info(), parameters(), TransformShifted<TransformHp3<uint16_t>>(shift));
+            return allocate_unique<ProcessTransformed<TransformShifted<TransformHp3<uint16_t>>>>(Strategy::allocator_, info, stride, frame_info(), parameters(), TransformShifted<TransformHp3<uint16_t>>(shift), simd_dispatch, Strategy::allocator_);
         default:
             impl::throw_jpegls_error(jpegls_errc::color_transform_not_supported);
         }
@@ -876,12 +1193,16 @@ std::unique_ptr<ProcessLine> JlsCodec<Traits, Strategy>::CreateProcess(ByteStrea
 // Setup codec for encoding and calls DoScan
 MSVC_WARNING_SUPPRESS(26433) // C.128: Virtual functions should specify exactly one of virtual, override, or final
 template<typename Traits, typename Strategy>
-size_t JlsCodec<Traits, Strategy>::EncodeScan(std::unique_ptr<ProcessLine> processLine, ByteStreamInfo& compressedData)
+size_t JlsCodec<Traits, Strategy>::EncodeScan(allocated_ptr<ProcessLine> processLine, ByteStreamInfo& compressedData)
 {
     Strategy::processLine_ = std::move(processLine);
 
     Strategy::Init(compressedData);
-    DoScan();
+    ResetParams();
+    if (!TryDoScanInPlace(static_cast<PIXEL*>(nullptr)))
+    {
+        DoScan();
+    }
 
     return Strategy::GetLength();
 }
@@ -889,7 +1210,7 @@ size_t JlsCodec<Traits, Strategy>::EncodeScan(std::unique_ptr<ProcessLine> proce
 
 // Setup codec for decoding and calls DoScan
 template<typename Traits, typename Strategy>
-void JlsCodec<Traits, Strategy>::DecodeScan(std::unique_ptr<ProcessLine> processLine, const JlsRect& rect, ByteStreamInfo& compressedData)
+void JlsCodec<Traits, Strategy>::DecodeScan(allocated_ptr<ProcessLine> processLine, const JlsRect& rect, ByteStreamInfo& compressedData)
 {
     Strategy::processLine_ = std::move(processLine);
 
@@ -897,7 +1218,11 @@ void JlsCodec<Traits, Strategy>::DecodeScan(std::unique_ptr<ProcessLine> process
     rect_ = rect;
 
     Strategy::Init(compressedData);
-    DoScan();
+    ResetParams();
+    if (!TryDoScanInPlace(static_cast<PIXEL*>(nullptr)))
+    {
+        DoScan();
+    }
     SkipBytes(compressedData, Strategy::GetCurBytePos() - compressedBytes);
 }
 MSVC_WARNING_UNSUPPRESS()
@@ -909,17 +1234,25 @@ void JlsCodec<Traits, Strategy>::InitParams(const int32_t t1, const int32_t t2,
     T1 = t1;
     T2 = t2;
     T3 = t3;
+    nReset_ = nReset;
 
     InitQuantizationLUT();
+    ResetParams();
+}
+
 
+// Resets the adaptive coding state to its initial values, done at the start of a scan and at every restart marker.
+template<typename Traits, typename Strategy>
+void JlsCodec<Traits, Strategy>::ResetParams() noexcept
+{
     const JlsContext contextInitValue(std::max(2, (traits.RANGE + 32) / 64));
     for (auto& context : contexts_)
     {
         context = contextInitValue;
     }
 
-    contextRunmode_[0] = CContextRunMode(std::max(2, (traits.RANGE + 32) / 64), 0, nReset);
-    contextRunmode_[1] = CContextRunMode(std::max(2, (traits.RANGE + 32) / 64), 1, nReset);
+    contextRunmode_[0] = CContextRunMode(std::max(2, (traits.RANGE + 32) / 64), 0, nReset_);
+    contextRunmode_[1] = CContextRunMode(std::max(2, (traits.RANGE + 32) / 64), 1, nReset_);
     RUNindex_ = 0;
 }
 
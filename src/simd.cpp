@@ -0,0 +1,25 @@
+// Copyright (c) Team CharLS.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "simd.h"
+
+namespace charls {
+
+// Constant initialized with the baseline functions: they can already be used during the dynamic initialization of other
+// translation units (for example by global objects of the application that is using the library).
+simd_functions simd_dispatch{get_simd_functions(instruction_set::baseline)};
+
+namespace {
+
+// Probes the CPU when the library is loaded and selects the best functions.
+struct simd_dispatch_initializer final
+{
+    simd_dispatch_initializer() noexcept
+    {
+        simd_dispatch = get_simd_functions(detected_instruction_set());
+    }
+} const initializer;
+
+} // namespace
+
+} // namespace charls
@@ -0,0 +1,711 @@
+// Copyright (c) Team CharLS.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#include "cpu_features.h"
+#include "util.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+// Select the baseline vector instruction set at compile time. SSE2 is always available on x64 and
+// NEON on ARM64, AVX2 is used when the compiler is allowed to generate it (-mavx2 or /arch:AVX2).
+// With runtime dispatch the AVX2 functions are also compiled for a SSE2 baseline and selected when the CPU supports AVX2.
+#if defined(__AVX2__)
+#define CHARLS_SIMD_AVX2
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CHARLS_SIMD_SSE2
+#include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define CHARLS_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+#if defined(CHARLS_RUNTIME_DISPATCH) && !defined(CHARLS_SIMD_AVX2)
+#include <immintrin.h>
+#endif
+
+namespace charls {
+
+namespace simd_detail {
+
+// The operations structs wrap the instructions of a vector instruction set that the functions below need:
+// the same function template is compiled for every instruction set.
+// Note: vector types are not passed to or returned from the function templates, their ABI depends on the instruction set.
+
+#if defined(CHARLS_SIMD_AVX2) || defined(CHARLS_RUNTIME_DISPATCH)
+struct avx2_operations final
+{
+    static constexpr size_t vector_size = 32;
+    static constexpr int32_t mask_bits_per_byte = 1;
+    static constexpr uint64_t all_bytes_mask = 0xFFFFFFFF;
+
+    // Returns a mask with mask_bits_per_byte bits set for every byte that is equal to the byte of value at that position.
+    CHARLS_TARGET_AVX2 static uint64_t match_mask(const uint8_t* position, const uint8_t value) noexcept
+    {
+        return match_mask(position, _mm256_set1_epi8(static_cast<char>(value)));
+    }
+
+    CHARLS_TARGET_AVX2 static uint64_t match_mask(const uint8_t* position, const uint16_t value) noexcept
+    {
+        return match_mask(position, _mm256_set1_epi16(static_cast<short>(value)));
+    }
+
+private:
+    CHARLS_TARGET_AVX2 static uint64_t match_mask(const uint8_t* position, const __m256i pattern) noexcept
+    {
+        const __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(position));
+        return static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, pattern)));
+    }
+};
+#endif
+
+#if defined(CHARLS_SIMD_SSE2)
+struct sse2_operations final
+{
+    static constexpr size_t vector_size = 16;
+    static constexpr int32_t mask_bits_per_byte = 1;
+    static constexpr uint64_t all_bytes_mask = 0xFFFF;
+
+    static uint64_t match_mask(const uint8_t* position, const uint8_t value) noexcept
+    {
+        return match_mask(position, _mm_set1_epi8(static_cast<char>(value)));
+    }
+
+    static uint64_t match_mask(const uint8_t* position, const uint16_t value) noexcept
+    {
+        return match_mask(position, _mm_set1_epi16(static_cast<short>(value)));
+    }
+
+private:
+    static uint64_t match_mask(const uint8_t* position, const __m128i pattern) noexcept
+    {
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(position));
+        return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, pattern)));
+    }
+};
+#endif
+
+#if defined(CHARLS_SIMD_NEON)
+struct neon_operations final
+{
+    static constexpr size_t vector_size = 16;
+
+    // Every 8 bit compare result is narrowed to 4 bits: a 64 bit mask with 4 bits per byte.
+    static constexpr int32_t mask_bits_per_byte = 4;
+    static constexpr uint64_t all_bytes_mask = 0xFFFFFFFFFFFFFFFF;
+
+    static uint64_t match_mask(const uint8_t* position, const uint8_t value) noexcept
+    {
+        return match_mask(position, vdupq_n_u8(value));
+    }
+
+    static uint64_t match_mask(const uint8_t* position, const uint16_t value) noexcept
+    {
+        return match_mask(position, vreinterpretq_u8_u16(vdupq_n_u16(value)));
+    }
+
+private:
+    static uint64_t match_mask(const uint8_t* position, const uint8x16_t pattern) noexcept
+    {
+        const uint8x16_t equal = vceqq_u8(vld1q_u8(position), pattern);
+        return vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(equal), 4)), 0);
+    }
+};
+#endif
+
+// No vector instructions: the functions below only use their scalar loop.
+struct scalar_operations final
+{
+};
+
+#if defined(CHARLS_SIMD_AVX2)
+using baseline_operations = avx2_operations;
+#elif defined(CHARLS_SIMD_SSE2)
+using baseline_operations = sse2_operations;
+#elif defined(CHARLS_SIMD_NEON)
+using baseline_operations = neon_operations;
+#else
+using baseline_operations = scalar_operations;
+#endif
+
+template<typename Operations>
+const uint8_t* find_jpeg_marker_start_byte(const uint8_t* position, const uint8_t* const end, std::true_type /*vector*/) noexcept
+{
+    for (; end - position >= static_cast<ptrdiff_t>(Operations::vector_size); position += Operations::vector_size)
+    {
+        const uint64_t mask = Operations::match_mask(position, static_cast<uint8_t>(0xFF));
+        if (mask != 0)
+            return position + countr_zero(mask) / Operations::mask_bits_per_byte;
+    }
+
+    return std::find(position, end, static_cast<uint8_t>(0xFF));
+}
+
+template<typename Operations>
+const uint8_t* find_jpeg_marker_start_byte(const uint8_t* position, const uint8_t* const end, std::false_type /*vector*/) noexcept
+{
+    return std::find(position, end, static_cast<uint8_t>(0xFF));
+}
+
+template<typename Operations, typename T>
+size_t count_equal_values(const T* values, const size_t count, const T value, std::true_type /*vector*/) noexcept
+{
+    constexpr size_t values_per_step = Operations::vector_size / sizeof(T);
+
+    size_t index{};
+    for (; count - index >= values_per_step; index += values_per_step)
+    {
+        const uint64_t mask = Operations::match_mask(reinterpret_cast<const uint8_t*>(values + index), value) ^ Operations::all_bytes_mask;
+        if (mask != 0)
+            return index + static_cast<size_t>(countr_zero(mask)) / (Operations::mask_bits_per_byte * sizeof(T));
+    }
+
+    while (index < count && values[index] == value)
+    {
+        ++index;
+    }
+
+    return index;
+}
+
+template<typename Operations, typename T>
+size_t count_equal_values(const T* values, const size_t count, const T value, std::false_type /*vector*/) noexcept
+{
+    size_t index{};
+    while (index < count && values[index] == value)
+    {
+        ++index;
+    }
+
+    return index;
+}
+
+template<typename Operations>
+using has_vector = std::integral_constant<bool, !std::is_same<Operations, scalar_operations>::value>;
+
+template<typename Operations>
+const uint8_t* find_jpeg_marker_start_byte(const uint8_t* position, const uint8_t* const end) noexcept
+{
+    return find_jpeg_marker_start_byte<Operations>(position, end, has_vector<Operations>());
+}
+
+template<typename Operations, typename T>
+size_t count_equal_values(const T* values, const size_t count, const T value) noexcept
+{
+    return count_equal_values<Operations>(values, count, value, has_vector<Operations>());
+}
+
+#if defined(CHARLS_RUNTIME_DISPATCH) && !defined(CHARLS_SIMD_AVX2)
+CHARLS_TARGET_AVX2 inline const uint8_t* find_jpeg_marker_start_byte_avx2(const uint8_t* position, const uint8_t* const end) noexcept
+{
+    return find_jpeg_marker_start_byte<avx2_operations>(position, end);
+}
+
+CHARLS_TARGET_AVX2 inline size_t count_equal_values_avx2(const uint8_t* values, const size_t count, const uint8_t value) noexcept
+{
+    return count_equal_values<avx2_operations>(values, count, value);
+}
+
+CHARLS_TARGET_AVX2 inline size_t count_equal_values_avx2(const uint16_t* values, const size_t count, const uint16_t value) noexcept
+{
+    return count_equal_values<avx2_operations>(values, count, value);
+}
+#endif
+
+#if defined(CHARLS_RUNTIME_DISPATCH)
+// SSE 4.2 functions that (de)interleave the samples of pixels with 3 components of 8 or 16 bit and apply the color
+// transforms of color_transform.h. The components of 16 bytes of pixels are gathered with byte shuffles (pshufb).
+
+// Shuffle masks that gather the samples of one component from 3 vectors of interleaved pixels (deinterleave) and
+// that scatter the samples of 3 component vectors to 3 vectors of interleaved pixels (interleave). -1 clears a byte.
+struct triplet_shuffle_masks final
+{
+    int8_t deinterleave[3][3][16]; // [component][pixel vector][byte]
+    int8_t interleave[3][3][16];   // [pixel vector][component][byte]
+};
+
+template<size_t SampleSize>
+constexpr triplet_shuffle_masks make_triplet_shuffle_masks() noexcept
+{
+    triplet_shuffle_masks masks{};
+    for (size_t component = 0; component < 3; ++component)
+    {
+        for (size_t pixel_vector = 0; pixel_vector < 3; ++pixel_vector)
+        {
+            for (size_t byte = 0; byte < 16; ++byte)
+            {
+                const size_t pixel_byte = (byte / SampleSize * 3 + component) * SampleSize + byte % SampleSize;
+                masks.deinterleave[component][pixel_vector][byte] =
+                    static_cast<int8_t>(pixel_byte / 16 == pixel_vector ? static_cast<int>(pixel_byte % 16) : -1);
+
+                const size_t sample = (pixel_vector * 16 + byte) / SampleSize;
+                masks.interleave[pixel_vector][component][byte] =
+                    static_cast<int8_t>(sample % 3 == component ? static_cast<int>(sample / 3 * SampleSize + byte % SampleSize) : -1);
+            }
+        }
+    }
+
+    return masks;
+}
+
+template<size_t SampleSize>
+const triplet_shuffle_masks& get_triplet_shuffle_masks() noexcept
+{
+    static constexpr triplet_shuffle_masks masks{make_triplet_shuffle_masks<SampleSize>()};
+    return masks;
+}
+
+CHARLS_TARGET_SSE4_2 inline __m128i load_mask(const int8_t* mask) noexcept
+{
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(mask));
+}
+
+// Combines the bytes that the 3 masks select from the 3 vectors.
+// Note: the vectors are passed by reference and the callers are unrolled by hand: at -O2 loops over arrays of vectors
+//       are not unrolled and the vectors are stored to the stack.
+CHARLS_TARGET_SSE4_2 inline __m128i shuffle_triplets(const int8_t (&masks)[3][16], const __m128i& a, const __m128i& b, const __m128i& c) noexcept
+{
+    return _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a, load_mask(masks[0])), _mm_shuffle_epi8(b, load_mask(masks[1]))),
+                        _mm_shuffle_epi8(c, load_mask(masks[2])));
+}
+
+// Gathers the 3 component vectors v1, v2 and v3 from the 3 vectors of interleaved pixels p0, p1 and p2.
+CHARLS_TARGET_SSE4_2 inline void deinterleave_triplets(const triplet_shuffle_masks& masks, const __m128i& p0, const __m128i& p1,
+                                                       const __m128i& p2, __m128i& v1, __m128i& v2, __m128i& v3) noexcept
+{
+    v1 = shuffle_triplets(masks.deinterleave[0], p0, p1, p2);
+    v2 = shuffle_triplets(masks.deinterleave[1], p0, p1, p2);
+    v3 = shuffle_triplets(masks.deinterleave[2], p0, p1, p2);
+}
+
+// Scatters the 3 component vectors v1, v2 and v3 to the 3 vectors of interleaved pixels p0, p1 and p2.
+CHARLS_TARGET_SSE4_2 inline void interleave_triplets(const triplet_shuffle_masks& masks, const __m128i& v1, const __m128i& v2,
+                                                     const __m128i& v3, __m128i& p0, __m128i& p1, __m128i& p2) noexcept
+{
+    p0 = shuffle_triplets(masks.interleave[0], v1, v2, v3);
+    p1 = shuffle_triplets(masks.interleave[1], v1, v2, v3);
+    p2 = shuffle_triplets(masks.interleave[2], v1, v2, v3);
+}
+
+// The arithmetic of the color transforms on vectors of 8 or 16 bit samples, results wrap around like the scalar code.
+template<typename T>
+struct sse42_sample_operations;
+
+template<>
+struct sse42_sample_operations<uint8_t> final
+{
+    CHARLS_TARGET_SSE4_2 static __m128i set(const int value) noexcept
+    {
+        return _mm_set1_epi8(static_cast<char>(value));
+    }
+
+    CHARLS_TARGET_SSE4_2 static __m128i add(const __m128i a, const __m128i b) noexcept
+    {
+        return _mm_add_epi8(a, b);
+    }
+
+    CHARLS_TARGET_SSE4_2 static __m128i subtract(const __m128i a, const __m128i b) noexcept
+    {
+        return _mm_sub_epi8(a, b);
+    }
+
+    // Returns (a + b) >> 1: the rounding average minus the rounding bit.
+    CHARLS_TARGET_SSE4_2 static __m128i average(const __m128i a, const __m128i b) noexcept
+    {
+        return _mm_sub_epi8(_mm_avg_epu8(a, b), _mm_and_si128(_mm_xor_si128(a, b), set(1)));
+    }
+
+    CHARLS_TARGET_SSE4_2 static __m128i shift_right_1(const __m128i a) noexcept
+    {
+        return _mm_and_si128(_mm_srli_epi16(a, 1), set(0x7F));
+    }
+};
+
+template<>
+struct sse42_sample_operations<uint16_t> final
+{
+    CHARLS_TARGET_SSE4_2 static __m128i set(const int value) noexcept
+    {
+        return _mm_set1_epi16(static_cast<short>(value));
+    }
+
+    CHARLS_TARGET_SSE4_2 static __m128i add(const __m128i a, const __m128i b) noexcept
+    {
+        return _mm_add_epi16(a, b);
+    }
+
+    CHARLS_TARGET_SSE4_2 static __m128i subtract(const __m128i a, const __m128i b) noexcept
+    {
+        return _mm_sub_epi16(a, b);
+    }
+
+    // Returns (a + b) >> 1: the rounding average minus the rounding bit.
+    CHARLS_TARGET_SSE4_2 static __m128i average(const __m128i a, const __m128i b) noexcept
+    {
+        return _mm_sub_epi16(_mm_avg_epu16(a, b), _mm_and_si128(_mm_xor_si128(a, b), set(1)));
+    }
+
+    CHARLS_TARGET_SSE4_2 static __m128i shift_right_1(const __m128i a) noexcept
+    {
+        return _mm_srli_epi16(a, 1);
+    }
+};
+
+template<typename T>
+constexpr int half_range() noexcept
+{
+    return 1 << (sizeof(T) * 8 - 1);
+}
+
+// The color transforms: apply converts the 3 component vectors in place, the same way as the scalar transform.
+struct sse42_transform_none final
+{
+    template<typename T>
+    CHARLS_TARGET_SSE4_2 static void apply(__m128i& /*v1*/, __m128i& /*v2*/, __m128i& /*v3*/) noexcept
+    {
+    }
+};
+
+struct sse42_transform_hp1 final
+{
+    template<typename T>
+    CHARLS_TARGET_SSE4_2 static void apply(__m128i& red, __m128i& green, __m128i& blue) noexcept
+    {
+        using operations = sse42_sample_operations<T>;
+        const __m128i half = operations::set(half_range<T>());
+        red = operations::add(operations::subtract(red, green), half);
+        blue = operations::add(operations::subtract(blue, green), half);
+    }
+};
+
+struct sse42_inverse_transform_hp1 final
+{
+    template<typename T>
+    CHARLS_TARGET_SSE4_2 static void apply(__m128i& v1, __m128i& v2, __m128i& v3) noexcept
+    {
+        using operations = sse42_sample_operations<T>;
+        const __m128i half = operations::set(half_range<T>());
+        v1 = operations::subtract(operations::add(v1, v2), half);
+        v3 = operations::subtract(operations::add(v3, v2), half);
+    }
+};
+
+struct sse42_transform_hp2 final
+{
+    template<typename T>
+    CHARLS_TARGET_SSE4_2 static void apply(__m128i& red, __m128i& green, __m128i& blue) noexcept
+    {
+        using operations = sse42_sample_operations<T>;
+        const __m128i half = operations::set(half_range<T>());
+        blue = operations::subtract(operations::subtract(blue, operations::average(red, green)), half);
+        red = operations::add(operations::subtract(red, green), half);
+    }
+};
+
+struct sse42_inverse_transform_hp2 final
+{
+    template<typename T>
+    CHARLS_TARGET_SSE4_2 static void apply(__m128i& v1, __m128i& v2, __m128i& v3) noexcept
+    {
+        using operations = sse42_sample_operations<T>;
+        const __m128i half = operations::set(half_range<T>());
+        v1 = operations::subtract(operations::add(v1, v2), half);
+        v3 = operations::subtract(operations::add(v3, operations::average(v1, v2)), half);
+    }
+};
+
+struct sse42_transform_hp3 final
+{
+    template<typename T>
+    CHARLS_TARGET_SSE4_2 static void apply(__m128i& red, __m128i& green, __m128i& blue) noexcept
+    {
+        using operations = sse42_sample_operations<T>;
+        const __m128i half = operations::set(half_range<T>());
+        const __m128i v2 = operations::add(operations::subtract(blue, green), half);
+        const __m128i v3 = operations::add(operations::subtract(red, green), half);
+
+        // (v2 + v3) >> 2 is computed as ((v2 + v3) >> 1) >> 1, the sum doesn't fit in a sample.
+        red = operations::subtract(operations::add(green, operations::shift_right_1(operations::average(v2, v3))), operations::set(half_range<T>() / 2));
+        green = v2;
+        blue = v3;
+    }
+};
+
+struct sse42_inverse_transform_hp3 final
+{
+    template<typename T>
+    CHARLS_TARGET_SSE4_2 static void apply(__m128i& v1, __m128i& v2, __m128i& v3) noexcept
+    {
+        using operations = sse42_sample_operations<T>;
+        const __m128i half = operations::set(half_range<T>());
+        const __m128i green = operations::add(operations::subtract(v1, operations::shift_right_1(operations::average(v3, v2))), operations::set(half_range<T>() / 2));
+        const __m128i red = operations::subtract(operations::add(v3, green), half);
+        v3 = operations::subtract(operations::add(v2, green), half);
+        v1 = red;
+        v2 = green;
+    }
+};
+
+// Converts pixels with 3 interleaved components to 3 component lines, stride samples apart.
+// Returns the number of pixels that have been converted, the caller converts the remaining pixels.
+template<typename Transform, typename T>
+CHARLS_TARGET_SSE4_2 int triplets_to_lines_sse42(const T* source, const int pixel_count, T* destination, const size_t stride) noexcept
+{
+    constexpr int pixels_per_step = 16 / sizeof(T);
+    const triplet_shuffle_masks& masks{get_triplet_shuffle_masks<sizeof(T)>()};
+
+    int pixel{};
+    for (; pixel_count - pixel >= pixels_per_step; pixel += pixels_per_step)
+    {
+        const auto* pixels = reinterpret_cast<const __m128i*>(source + static_cast<size_t>(pixel) * 3);
+        __m128i v1;
+        __m128i v2;
+        __m128i v3;
+        deinterleave_triplets(masks, _mm_loadu_si128(pixels), _mm_loadu_si128(pixels + 1), _mm_loadu_si128(pixels + 2), v1, v2, v3);
+        Transform::template apply<T>(v1, v2, v3);
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + pixel), v1);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + pixel + stride), v2);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + pixel + 2 * stride), v3);
+    }
+
+    return pixel;
+}
+
+// Converts 3 component lines, stride samples apart, to pixels with 3 interleaved components.
+// Returns the number of pixels that have been converted, the caller converts the remaining pixels.
+template<typename Transform, typename T>
+CHARLS_TARGET_SSE4_2 int lines_to_triplets_sse42(const T* source, const size_t stride, T* destination, const int pixel_count) noexcept
+{
+    constexpr int pixels_per_step = 16 / sizeof(T);
+    const triplet_shuffle_masks& masks{get_triplet_shuffle_masks<sizeof(T)>()};
+
+    int pixel{};
+    for (; pixel_count - pixel >= pixels_per_step; pixel += pixels_per_step)
+    {
+        __m128i v1{_mm_loadu_si128(reinterpret_cast<const __m128i*>(source + pixel))};
+        __m128i v2{_mm_loadu_si128(reinterpret_cast<const __m128i*>(source + pixel + stride))};
+        __m128i v3{_mm_loadu_si128(reinterpret_cast<const __m128i*>(source + pixel + 2 * stride))};
+        Transform::template apply<T>(v1, v2, v3);
+
+        __m128i p0;
+        __m128i p1;
+        __m128i p2;
+        interleave_triplets(masks, v1, v2, v3, p0, p1, p2);
+        auto* pixels = reinterpret_cast<__m128i*>(destination + static_cast<size_t>(pixel) * 3);
+        _mm_storeu_si128(pixels, p0);
+        _mm_storeu_si128(pixels + 1, p1);
+        _mm_storeu_si128(pixels + 2, p2);
+    }
+
+    return pixel;
+}
+
+// Applies the color transform to pixels with 3 interleaved components, source and destination may be the same.
+// Returns the number of pixels that have been converted, the caller converts the remaining pixels.
+template<typename Transform, typename T>
+CHARLS_TARGET_SSE4_2 int transform_triplets_sse42(const T* source, T* destination, const int pixel_count) noexcept
+{
+    constexpr int pixels_per_step = 16 / sizeof(T);
+    const triplet_shuffle_masks& masks{get_triplet_shuffle_masks<sizeof(T)>()};
+
+    int pixel{};
+    for (; pixel_count - pixel >= pixels_per_step; pixel += pixels_per_step)
+    {
+        const auto* source_pixels = reinterpret_cast<const __m128i*>(source + static_cast<size_t>(pixel) * 3);
+        __m128i v1;
+        __m128i v2;
+        __m128i v3;
+        deinterleave_triplets(masks, _mm_loadu_si128(source_pixels), _mm_loadu_si128(source_pixels + 1), _mm_loadu_si128(source_pixels + 2), v1, v2, v3);
+        Transform::template apply<T>(v1, v2, v3);
+
+        __m128i p0;
+        __m128i p1;
+        __m128i p2;
+        interleave_triplets(masks, v1, v2, v3, p0, p1, p2);
+        auto* destination_pixels = reinterpret_cast<__m128i*>(destination + static_cast<size_t>(pixel) * 3);
+        _mm_storeu_si128(destination_pixels, p0);
+        _mm_storeu_si128(destination_pixels + 1, p1);
+        _mm_storeu_si128(destination_pixels + 2, p2);
+    }
+
+    return pixel;
+}
+#endif
+
+} // namespace simd_detail
+
+
+// Purpose: vectorized functions that apply a color transform to pixels with 3 components of 8 or 16 bit and
+//          (de)interleave them. They return the number of pixels that have been converted: the caller converts the
+//          remaining pixels with the scalar transforms of color_transform.h.
+//          There are no vectorized functions for the shifted transforms, 4 components or BGR output.
+template<typename T>
+struct triplet_line_functions final
+{
+    int (*transform_triplets)(const T* source, T* destination, int pixel_count) noexcept;
+    int (*triplets_to_lines)(const T* source, int pixel_count, T* destination, size_t stride) noexcept;
+    int (*inverse_transform_triplets)(const T* source, T* destination, int pixel_count) noexcept;
+    int (*lines_to_triplets)(const T* source, size_t stride, T* destination, int pixel_count) noexcept;
+};
+
+namespace simd_detail {
+
+// Without vector instructions no pixels are converted.
+template<typename T>
+int transform_triplets_scalar(const T* /*source*/, T* /*destination*/, int /*pixel_count*/) noexcept
+{
+    return 0;
+}
+
+template<typename T>
+int triplets_to_lines_scalar(const T* /*source*/, int /*pixel_count*/, T* /*destination*/, size_t /*stride*/) noexcept
+{
+    return 0;
+}
+
+template<typename T>
+int lines_to_triplets_scalar(const T* /*source*/, size_t /*stride*/, T* /*destination*/, int /*pixel_count*/) noexcept
+{
+    return 0;
+}
+
+template<typename T>
+constexpr triplet_line_functions<T> scalar_triplet_line_functions() noexcept
+{
+    return {transform_triplets_scalar<T>, triplets_to_lines_scalar<T>, transform_triplets_scalar<T>, lines_to_triplets_scalar<T>};
+}
+
+#if defined(CHARLS_RUNTIME_DISPATCH)
+template<typename Transform, typename InverseTransform, typename T>
+constexpr triplet_line_functions<T> sse42_triplet_line_functions() noexcept
+{
+    return {transform_triplets_sse42<Transform, T>, triplets_to_lines_sse42<Transform, T>,
+            transform_triplets_sse42<InverseTransform, T>, lines_to_triplets_sse42<InverseTransform, T>};
+}
+#endif
+
+} // namespace simd_detail
+
+
+// Purpose: table with the vectorized functions used by the codec, compiled for one instruction set.
+struct simd_functions final
+{
+    const uint8_t* (*find_jpeg_marker_start_byte)(const uint8_t* position, const uint8_t* end) noexcept;
+    size_t (*count_equal_values_8)(const uint8_t* values, size_t count, uint8_t value) noexcept;
+    size_t (*count_equal_values_16)(const uint16_t* values, size_t count, uint16_t value) noexcept;
+
+    // Indexed by the color transformation: none, HP1, HP2 and HP3.
+    triplet_line_functions<uint8_t> triplet_lines_8[4];
+    triplet_line_functions<uint16_t> triplet_lines_16[4];
+};
+
+
+namespace simd_detail {
+
+// Purpose: returns the functions that use no vector instructions at all.
+constexpr simd_functions scalar_simd_functions() noexcept
+{
+    return {find_jpeg_marker_start_byte<scalar_operations>,
+            count_equal_values<scalar_operations, uint8_t>,
+            count_equal_values<scalar_operations, uint16_t>,
+            {scalar_triplet_line_functions<uint8_t>(), scalar_triplet_line_functions<uint8_t>(),
+             scalar_triplet_line_functions<uint8_t>(), scalar_triplet_line_functions<uint8_t>()},
+            {scalar_triplet_line_functions<uint16_t>(), scalar_triplet_line_functions<uint16_t>(),
+             scalar_triplet_line_functions<uint16_t>(), scalar_triplet_line_functions<uint16_t>()}};
+}
+
+} // namespace simd_detail
+
+
+// Purpose: returns the functions compiled for the instruction set, or for the best instruction set below it for which
+//          the library has no specialized functions.
+//          The baseline searches with SSE2, AVX2 (when compiled for it) or NEON and converts pixels with scalar code.
+//          SSE 4.2 adds the byte shuffles used to (de)interleave pixels. AVX2 adds 32 byte searches: the SSE 4.2
+//          (de)interleave functions are used for AVX2 as well, they are limited by the byte shuffles.
+constexpr simd_functions get_simd_functions(const instruction_set isa) noexcept
+{
+    simd_functions functions{simd_detail::scalar_simd_functions()};
+    functions.find_jpeg_marker_start_byte = simd_detail::find_jpeg_marker_start_byte<simd_detail::baseline_operations>;
+    functions.count_equal_values_8 = simd_detail::count_equal_values<simd_detail::baseline_operations, uint8_t>;
+    functions.count_equal_values_16 = simd_detail::count_equal_values<simd_detail::baseline_operations, uint16_t>;
+
+#if defined(CHARLS_RUNTIME_DISPATCH)
+    if (isa >= instruction_set::sse4_2)
+    {
+        using namespace simd_detail;
+        functions.triplet_lines_8[0] = sse42_triplet_line_functions<sse42_transform_none, sse42_transform_none, uint8_t>();
+        functions.triplet_lines_8[1] = sse42_triplet_line_functions<sse42_transform_hp1, sse42_inverse_transform_hp1, uint8_t>();
+        functions.triplet_lines_8[2] = sse42_triplet_line_functions<sse42_transform_hp2, sse42_inverse_transform_hp2, uint8_t>();
+        functions.triplet_lines_8[3] = sse42_triplet_line_functions<sse42_transform_hp3, sse42_inverse_transform_hp3, uint8_t>();
+        functions.triplet_lines_16[0] = sse42_triplet_line_functions<sse42_transform_none, sse42_transform_none, uint16_t>();
+        functions.triplet_lines_16[1] = sse42_triplet_line_functions<sse42_transform_hp1, sse42_inverse_transform_hp1, uint16_t>();
+        functions.triplet_lines_16[2] = sse42_triplet_line_functions<sse42_transform_hp2, sse42_inverse_transform_hp2, uint16_t>();
+        functions.triplet_lines_16[3] = sse42_triplet_line_functions<sse42_transform_hp3, sse42_inverse_transform_hp3, uint16_t>();
+    }
+#endif
+
+#if defined(CHARLS_RUNTIME_DISPATCH) && !defined(CHARLS_SIMD_AVX2)
+    if (isa >= instruction_set::avx2)
+    {
+        functions.find_jpeg_marker_start_byte = simd_detail::find_jpeg_marker_start_byte_avx2;
+        functions.count_equal_values_8 = simd_detail::count_equal_values_avx2;
+        functions.count_equal_values_16 = simd_detail::count_equal_values_avx2;
+    }
+#endif
+
+#if !defined(CHARLS_RUNTIME_DISPATCH)
+    static_cast<void>(isa);
+#endif
+
+    return functions;
+}
+
+
+// The functions for the CPU the library runs on, selected when the library is loaded (see simd.cpp).
+extern simd_functions simd_dispatch;
+
+
+// Purpose: returns the position of the first 0xFF byte in [position, end) or end when there is none.
+//          Tests 16 (SSE2, NEON) or 32 (AVX2) bytes per step, the remaining bytes are tested one at a time.
+inline const uint8_t* find_jpeg_marker_start_byte(const uint8_t* position, const uint8_t* const end) noexcept
+{
+    return simd_dispatch.find_jpeg_marker_start_byte(position, end);
+}
+
+
+// Purpose: returns the number of values at the start of [values, values + count) that are equal to value.
+//          Used to find the length of a run of equal samples when encoding lossless.
+inline size_t count_equal_values(const uint8_t* values, const size_t count, const uint8_t value) noexcept
+{
+    return simd_dispatch.count_equal_values_8(values, count, value);
+}
+
+inline size_t count_equal_values(const uint16_t* values, const size_t count, const uint16_t value) noexcept
+{
+    return simd_dispatch.count_equal_values_16(values, count, value);
+}
+
+
+// Purpose: returns the functions of the table that convert pixels with 3 components of 8 or 16 bit.
+template<typename T>
+const triplet_line_functions<T>& get_triplet_line_functions(const simd_functions& functions, color_transformation transformation) noexcept;
+
+template<>
+inline const triplet_line_functions<uint8_t>& get_triplet_line_functions<uint8_t>(const simd_functions& functions, const color_transformation transformation) noexcept
+{
+    return functions.triplet_lines_8[static_cast<size_t>(transformation)];
+}
+
+template<>
+inline const triplet_line_functions<uint16_t>& get_triplet_line_functions<uint16_t>(const simd_functions& functions, const color_transformation transformation) noexcept
+{
+    return functions.triplet_lines_16[static_cast<size_t>(transformation)];
+}
+
+} // namespace charls
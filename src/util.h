@@ -7,10 +7,16 @@
 #include <charls/charls_legacy.h>
 #include <charls/jpegls_error.h>
 
+#include <algorithm>
 #include <cassert>
 #include <cstring>
+#include <type_traits>
 #include <vector>
 
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
 // Use an uppercase alias for assert to make it clear that ASSERT is a pre-processor macro.
 #ifdef _MSC_VER
 #define ASSERT(expression)                 \
@@ -197,13 +203,15 @@ struct Triplet
 };
 
 
-inline bool operator==(const Triplet<uint8_t>& lhs, const Triplet<uint8_t>& rhs) noexcept
+template<typename T>
+bool operator==(const Triplet<T>& lhs, const Triplet<T>& rhs) noexcept
 {
     return lhs.v1 == rhs.v1 && lhs.v2 == rhs.v2 && lhs.v3 == rhs.v3;
 }
 
 
-inline bool operator!=(const Triplet<uint8_t>& lhs, const Triplet<uint8_t>& rhs) noexcept
+template<typename T>
+bool operator!=(const Triplet<T>& lhs, const Triplet<T>& rhs) noexcept
 {
     return !(lhs == rhs);
 }
@@ -236,6 +244,20 @@ struct Quad final : Triplet<sample>
 };
 
 
+template<typename T>
+bool operator==(const Quad<T>& lhs, const Quad<T>& rhs) noexcept
+{
+    return lhs.v1 == rhs.v1 && lhs.v2 == rhs.v2 && lhs.v3 == rhs.v3 && lhs.v4 == rhs.v4;
+}
+
+
+template<typename T>
+bool operator!=(const Quad<T>& lhs, const Quad<T>& rhs) noexcept
+{
+    return !(lhs == rhs);
+}
+
+
 template<int size>
 struct FromBigEndian final
 {
@@ -266,6 +288,211 @@ struct FromBigEndian<8> final
 };
 
 
+/// <summary>
+/// Assigns value to the first count elements of destination.
+/// Single samples use std::fill_n, which compilers turn into memset or vector broadcast stores.
+/// </summary>
+template<typename T>
+void fill_n_values(T* destination, const size_t count, const T value) noexcept
+{
+    std::fill_n(destination, count, value);
+}
+
+
+/// <summary>
+/// Assigns value to the first count pixels of destination (Triplet and Quad pixels).
+/// After the first block the range is filled with fixed size copies of that block, which compile to vector loads and stores.
+/// </summary>
+template<typename Pixel>
+void fill_n_pixels(Pixel* destination, const size_t count, const Pixel value) noexcept
+{
+    constexpr size_t block_count = 32;
+    const size_t scalarCount = std::min(count, block_count);
+    size_t i = 0;
+    for (; i < scalarCount; ++i)
+    {
+        destination[i] = value;
+    }
+
+    for (; count - i >= block_count; i += block_count)
+    {
+        memcpy(destination + i, destination, block_count * sizeof(Pixel));
+    }
+
+    for (; i < count; ++i)
+    {
+        destination[i] = value;
+    }
+}
+
+
+template<typename T>
+void fill_n_values(Triplet<T>* destination, const size_t count, const Triplet<T> value) noexcept
+{
+    fill_n_pixels(destination, count, value);
+}
+
+
+template<typename T>
+void fill_n_values(Quad<T>* destination, const size_t count, const Quad<T> value) noexcept
+{
+    fill_n_pixels(destination, count, value);
+}
+
+
+/// <summary>
+/// Writes a 64 bit value in big endian byte order, with a single byte swap and store on the supported compilers.
+/// </summary>
+inline void WriteBigEndian(uint8_t* buffer, const uint64_t value) noexcept
+{
+#if defined(__GNUC__) || defined(__clang__)
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    const uint64_t bigEndianValue = __builtin_bswap64(value);
+#else
+    const uint64_t bigEndianValue = value;
+#endif
+    memcpy(buffer, &bigEndianValue, sizeof bigEndianValue);
+#elif defined(_MSC_VER)
+    // All platforms supported by MSVC are little endian.
+    const uint64_t bigEndianValue = _byteswap_uint64(value);
+    memcpy(buffer, &bigEndianValue, sizeof bigEndianValue);
+#else
+    for (int i = 0; i < 8; ++i)
+    {
+        buffer[i] = static_cast<uint8_t>(value >> (56 - 8 * i));
+    }
+#endif
+}
+
+
+/// <summary>
+/// Returns a value with the high bit (0x80) set of every byte of value that is 0xFF (the JPEG marker start byte).
+/// Uses an exact zero byte test on the inverted value: there are no false positives caused by carries.
+/// </summary>
+template<typename T>
+constexpr T ff_byte_high_bits(const T value) noexcept
+{
+    static_assert(std::is_unsigned<T>::value, "T must be an unsigned type");
+    return ~(((~value & (~static_cast<T>(0) / 0xFF * 0x7F)) + ~static_cast<T>(0) / 0xFF * 0x7F) | ~value) &
+           (~static_cast<T>(0) / 0xFF * 0x80);
+}
+
+
+template<typename T>
+constexpr bool has_ff_byte(const T value) noexcept
+{
+    return ff_byte_high_bits(value) != 0;
+}
+
+
+/// <summary>
+/// Returns the number of consecutive 0 bits, starting from the most significant bit (equivalent of C++20 std::countl_zero).
+/// Uses a single instruction (lzcnt, bsr or clz) on the supported compilers and a portable implementation on others.
+/// </summary>
+template<typename T>
+FORCE_INLINE int32_t countl_zero(const T value) noexcept
+{
+    static_assert(std::is_unsigned<T>::value && (sizeof(T) == 4 || sizeof(T) == 8), "T must be an unsigned 32 or 64 bit type");
+    constexpr int32_t bit_count = sizeof(T) * 8;
+
+    if (value == 0)
+        return bit_count;
+
+#if defined(__GNUC__) || defined(__clang__)
+    return sizeof(T) == 4 ? __builtin_clz(static_cast<unsigned int>(value))
+                          : __builtin_clzll(static_cast<unsigned long long>(value));
+#elif defined(_MSC_VER)
+    unsigned long index;
+#if defined(_M_X64) || defined(_M_ARM64)
+    if (sizeof(T) == 8)
+    {
+        _BitScanReverse64(&index, static_cast<unsigned __int64>(value));
+        return bit_count - 1 - static_cast<int32_t>(index);
+    }
+#else
+    if (sizeof(T) == 8)
+    {
+        const auto high = static_cast<unsigned long>(static_cast<uint64_t>(value) >> 32);
+        if (high != 0)
+        {
+            _BitScanReverse(&index, high);
+            return 31 - static_cast<int32_t>(index);
+        }
+
+        _BitScanReverse(&index, static_cast<unsigned long>(value));
+        return 63 - static_cast<int32_t>(index);
+    }
+#endif
+    _BitScanReverse(&index, static_cast<unsigned long>(value));
+    return 31 - static_cast<int32_t>(index);
+#else
+    int32_t count{};
+    T test{value};
+    for (int32_t shift = bit_count / 2; shift != 0; shift /= 2)
+    {
+        if ((test >> (bit_count - shift)) == 0)
+        {
+            count += shift;
+            test <<= shift;
+        }
+    }
+    return count;
+#endif
+}
+
+
+/// <summary>
+/// Returns the number of consecutive 0 bits, starting from the least significant bit (equivalent of C++20 std::countr_zero).
+/// </summary>
+template<typename T>
+FORCE_INLINE int32_t countr_zero(const T value) noexcept
+{
+    static_assert(std::is_unsigned<T>::value && (sizeof(T) == 4 || sizeof(T) == 8), "T must be an unsigned 32 or 64 bit type");
+    constexpr int32_t bit_count = sizeof(T) * 8;
+
+    if (value == 0)
+        return bit_count;
+
+#if defined(__GNUC__) || defined(__clang__)
+    return sizeof(T) == 4 ? __builtin_ctz(static_cast<unsigned int>(value))
+                          : __builtin_ctzll(static_cast<unsigned long long>(value));
+#elif defined(_MSC_VER)
+    unsigned long index;
+#if defined(_M_X64) || defined(_M_ARM64)
+    if (sizeof(T) == 8)
+    {
+        _BitScanForward64(&index, static_cast<unsigned __int64>(value));
+        return static_cast<int32_t>(index);
+    }
+#else
+    if (sizeof(T) == 8)
+    {
+        const auto low = static_cast<unsigned long>(value);
+        if (low != 0)
+        {
+            _BitScanForward(&index, low);
+            return static_cast<int32_t>(index);
+        }
+
+        _BitScanForward(&index, static_cast<unsigned long>(static_cast<uint64_t>(value) >> 32));
+        return 32 + static_cast<int32_t>(index);
+    }
+#endif
+    _BitScanForward(&index, static_cast<unsigned long>(value));
+    return static_cast<int32_t>(index);
+#else
+    int32_t count{};
+    T test{value};
+    while ((test & 1) == 0)
+    {
+        ++count;
+        test >>= 1;
+    }
+    return count;
+#endif
+}
+
+
 inline void SkipBytes(ByteStreamInfo& streamInfo, const std::size_t count) noexcept
 {
     if (!streamInfo.rawData)
@@ -50,7 +50,7 @@ void TestJpegLsReadHeader()
     TestJpegLsReadHeader("test/conformance/T8NDE3.JLS", 128, 128, 8, 128, 1, 0);
     TestJpegLsReadHeader("test/conformance/T16E0.JLS", 256, 256, 12, 512, 1, 0);
     TestJpegLsReadHeader("test/conformance/T16E3.JLS", 256, 256, 12, 512, 1, 0);
-    TestJpegLsReadHeader("test/lena8b.JLS", 512, 512, 8, 512, 1, 0);
+    TestJpegLsReadHeader("test/lena8b.jls", 512, 512, 8, 512, 1, 0);
 }
 
 } // namespace
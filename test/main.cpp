@@ -589,7 +589,7 @@ void TestEncodeFromStream()
 }
 
 
-void UnitTest()
+bool UnitTest()
 {
     try
     {
@@ -634,7 +634,10 @@ void UnitTest()
     catch (const UnitTestException&)
     {
         cout << "==> Unit test failed <==\n";
+        return false;
     }
+
+    return true;
 }
 
 } // namespace
@@ -653,7 +656,8 @@ int main(const int argc, const char* const argv[]) // NOLINT(bugprone-exception-
         string str = argv[i];
         if (str == "-unittest")
         {
-            UnitTest();
+            if (!UnitTest())
+                return EXIT_FAILURE;
             continue;
         }
 
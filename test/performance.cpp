@@ -16,10 +16,13 @@ using std::milli;
 using std::vector;
 using std::chrono::duration;
 using std::chrono::steady_clock;
+using namespace charls;
 
 namespace {
 
-void TestFile16BitAs12(const char* filename, const int offset, const Size size2, const int componentCount, const bool littleEndianFile)
+// Reads 16 bit samples and reduces them to bitsPerSample bits, to measure the codecs for 10, 12 and 14 bit images.
+void TestFile16BitAs(const char* filename, const int offset, const Size size2, const int bitsPerSample, const int componentCount,
+                     const bool littleEndianFile, const interleave_mode interleaveMode, const int loopCount)
 {
     vector<uint8_t> uncompressedData = ReadFile(filename, offset);
 
@@ -29,10 +32,45 @@ void TestFile16BitAs12(const char* filename, const int offset, const Size size2,
 
     for (size_t i = 0; i < uncompressedData.size() / 2; ++i)
     {
-        p[i] = p[i] >> 4;
+        p[i] = static_cast<uint16_t>(p[i] >> (16 - bitsPerSample));
     }
 
-    TestRoundTrip(filename, uncompressedData, size2, 12, componentCount);
+    JlsParameters params{};
+    params.components = componentCount;
+    params.bitsPerSample = bitsPerSample;
+    params.height = static_cast<int>(size2.cy);
+    params.width = static_cast<int>(size2.cx);
+    params.interleaveMode = interleaveMode;
+
+    TestRoundTrip(filename, uncompressedData, params, loopCount);
+}
+
+
+// Measures near-lossless coding with the NEAR values that have an optimized codec (1, 2 and 3) and one that has not (4).
+void TestFileNearLossless(const char* filename, const int offset, const Size size2, const int bitsPerSample, const int componentCount,
+                          const bool littleEndianFile, const interleave_mode interleaveMode, const int loopCount)
+{
+    const size_t byteCount = size2.cx * size2.cy * componentCount * ((bitsPerSample + 7) / 8);
+    vector<uint8_t> uncompressedData = ReadFile(filename, offset, byteCount);
+
+    if (bitsPerSample > 8)
+    {
+        FixEndian(&uncompressedData, littleEndianFile);
+    }
+
+    for (int nearLossless = 1; nearLossless <= 4; ++nearLossless)
+    {
+        JlsParameters params{};
+        params.components = componentCount;
+        params.bitsPerSample = bitsPerSample;
+        params.height = static_cast<int>(size2.cy);
+        params.width = static_cast<int>(size2.cx);
+        params.interleaveMode = interleaveMode;
+        params.allowedLossyError = nearLossless;
+
+        cout << "NEAR = " << nearLossless << "\n";
+        TestRoundTrip(filename, uncompressedData, params, loopCount);
+    }
 }
 
 
@@ -49,6 +87,10 @@ void TestPerformance(const int loopCount)
     // 16 bit mono
     TestFile("test/MR2_UNC", 1728, size1024, 16, 1, true, loopCount);
 
+    // 10 and 14 bit mono
+    TestFile16BitAs("test/MR2_UNC", 1728, size1024, 10, 1, true, interleave_mode::none, loopCount);
+    TestFile16BitAs("test/MR2_UNC", 1728, size1024, 14, 1, true, interleave_mode::none, loopCount);
+
     // 8 bit mono
     TestFile("test/0015.raw", 0, size1024, 8, 1, false, loopCount);
     TestFile("test/lena8b.raw", 0, size512, 8, 1, false, loopCount);
@@ -56,12 +98,23 @@ void TestPerformance(const int loopCount)
     // 8 bit color
     TestFile("test/desktop.ppm", 40, Size(1280, 1024), 8, 3, false, loopCount);
 
+    // 10 bit RGB
+    TestFile16BitAs("test/DSC_5455.raw", 142949, Size(300, 200), 10, 3, true, interleave_mode::line, loopCount);
+    TestFile16BitAs("test/DSC_5455.raw", 142949, Size(300, 200), 10, 3, true, interleave_mode::sample, loopCount);
+
     // 12 bit RGB
     TestFile("test/SIEMENS-MR-RGB-16Bits.dcm", -1, Size(192, 256), 12, 3, true, loopCount);
-    TestFile16BitAs12("test/DSC_5455.raw", 142949, Size(300, 200), 3, true);
+    TestFile16BitAs("test/DSC_5455.raw", 142949, Size(300, 200), 12, 3, true, interleave_mode::line, loopCount);
+    TestFile16BitAs("test/DSC_5455.raw", 142949, Size(300, 200), 12, 3, true, interleave_mode::sample, loopCount);
 
     // 16 bit RGB
     TestFile("test/DSC_5455.raw", 142949, Size(300, 200), 16, 3, true, loopCount);
+    TestFile16BitAs("test/DSC_5455.raw", 142949, Size(300, 200), 16, 3, true, interleave_mode::sample, loopCount);
+
+    // Near-lossless
+    TestFileNearLossless("test/0015.raw", 0, size1024, 8, 1, false, interleave_mode::none, loopCount);
+    TestFileNearLossless("test/MR2_UNC", 1728, size1024, 16, 1, true, interleave_mode::none, loopCount);
+    TestFileNearLossless("test/desktop.ppm", 40, Size(1280, 1024), 8, 3, false, interleave_mode::sample, loopCount);
 }
 
 
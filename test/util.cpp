@@ -6,6 +6,7 @@
 #include "portable_anymap_file.h"
 
 #include <chrono>
+#include <cstdlib>
 #include <iomanip>
 #include <iostream>
 #include <vector>
@@ -39,6 +40,19 @@ bool IsMachineLittleEndian() noexcept
 MSVC_WARNING_UNSUPPRESS()
 
 
+template<typename SampleType>
+bool IsNearLosslessEqual(const SampleType* original, const SampleType* decoded, const size_t count, const int allowedLossyError) noexcept
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (std::abs(original[i] - decoded[i]) > allowedLossyError)
+            return false;
+    }
+
+    return true;
+}
+
+
 } // namespace
 
 
@@ -62,13 +76,13 @@ vector<uint8_t> ReadFile(const char* filename, long offset, size_t bytes)
 
     input.seekg(0, ios::end);
     const auto byteCountFile = static_cast<int>(input.tellg());
-    input.seekg(offset, ios::beg);
 
     if (offset < 0)
     {
         Assert::IsTrue(bytes != 0);
         offset = static_cast<long>(byteCountFile - bytes);
     }
+    input.seekg(offset, ios::beg);
     if (bytes == 0)
     {
         bytes = static_cast<size_t>(byteCountFile) - offset;
@@ -99,14 +113,23 @@ void TestRoundTrip(const char* strName, const vector<uint8_t>& originalBuffer, J
 
     vector<uint8_t> decodedBuffer(static_cast<size_t>(params.height) * params.width * ((params.bitsPerSample + 7) / 8) * params.components);
 
-    if (params.components == 4)
+    // Multi-component images use line interleave, unless the caller selected an interleave mode.
+    if (params.components == 4 && params.interleaveMode == interleave_mode::none)
     {
         params.interleaveMode = interleave_mode::line;
     }
     else if (params.components == 3)
     {
-        params.interleaveMode = interleave_mode::line;
-        params.colorTransformation = color_transformation::hp1;
+        if (params.interleaveMode == interleave_mode::none)
+        {
+            params.interleaveMode = interleave_mode::line;
+        }
+
+        // The NEAR error bound holds for the transformed components, not for the RGB samples.
+        if (params.allowedLossyError == 0)
+        {
+            params.colorTransformation = color_transformation::hp1;
+        }
     }
 
     size_t encoded_actual_size{};
@@ -137,15 +160,27 @@ void TestRoundTrip(const char* strName, const vector<uint8_t>& originalBuffer, J
 
     cout << "Size:" << setw(10) << params.width << "x" << params.height << setw(7) << setprecision(2) << ", Encode time:" << encodeTime << " ms, Decode time:" << decodeTime << " ms, Bits per sample:" << bitsPerSample << ", Decode rate:" << symbolRate << " M/s\n";
 
-    const uint8_t* byteOut = decodedBuffer.data();
-    for (size_t i = 0; i < decodedBuffer.size(); ++i)
+    if (params.allowedLossyError == 0)
     {
-        if (originalBuffer[i] != byteOut[i])
+        const uint8_t* byteOut = decodedBuffer.data();
+        for (size_t i = 0; i < decodedBuffer.size(); ++i)
         {
-            Assert::IsTrue(false);
-            break;
+            if (originalBuffer[i] != byteOut[i])
+            {
+                Assert::IsTrue(false);
+                break;
+            }
         }
     }
+    else if (params.bitsPerSample <= 8)
+    {
+        Assert::IsTrue(IsNearLosslessEqual(originalBuffer.data(), decodedBuffer.data(), decodedBuffer.size(), params.allowedLossyError));
+    }
+    else
+    {
+        Assert::IsTrue(IsNearLosslessEqual(reinterpret_cast<const uint16_t*>(originalBuffer.data()),
+                                           reinterpret_cast<const uint16_t*>(decodedBuffer.data()), decodedBuffer.size() / 2, params.allowedLossyError));
+    }
 }
 
 
@@ -157,6 +157,21 @@ TEST_CLASS(charls_jpegls_decoder_test)
         charls_jpegls_decoder_destroy(decoder);
     }
 
+    TEST_METHOD(set_maximum_thread_count_nullptr) // NOLINT
+    {
+        const auto error = charls_jpegls_decoder_set_maximum_thread_count(nullptr, 2);
+        Assert::AreEqual(jpegls_errc::invalid_argument, error);
+    }
+
+    TEST_METHOD(set_maximum_thread_count_negative) // NOLINT
+    {
+        auto* decoder = charls_jpegls_decoder_create();
+        const auto error = charls_jpegls_decoder_set_maximum_thread_count(decoder, -1);
+        Assert::AreEqual(jpegls_errc::invalid_argument, error);
+
+        charls_jpegls_decoder_destroy(decoder);
+    }
+
 private:
     static charls_jpegls_decoder* get_initialized_decoder()
     {
@@ -160,6 +160,57 @@ TEST_CLASS(charls_jpegls_encoder_test)
         charls_jpegls_encoder_destroy(encoder);
         Assert::AreEqual(jpegls_errc::invalid_argument, error);
     }
+
+    TEST_METHOD(set_maximum_thread_count_nullptr) // NOLINT
+    {
+        const auto error = charls_jpegls_encoder_set_maximum_thread_count(nullptr, 2);
+        Assert::AreEqual(jpegls_errc::invalid_argument, error);
+    }
+
+    TEST_METHOD(set_restart_interval_nullptr) // NOLINT
+    {
+        const auto error = charls_jpegls_encoder_set_restart_interval(nullptr, 8);
+        Assert::AreEqual(jpegls_errc::invalid_argument, error);
+    }
+
+    TEST_METHOD(get_component_error_metrics_nullptr) // NOLINT
+    {
+        charls_component_error_metrics error_metrics{};
+        auto error = charls_jpegls_encoder_get_component_error_metrics(nullptr, 0, &error_metrics);
+        Assert::AreEqual(jpegls_errc::invalid_argument, error);
+
+        auto* const encoder = charls_jpegls_encoder_create();
+        error = charls_jpegls_encoder_get_component_error_metrics(encoder, 0, nullptr);
+        charls_jpegls_encoder_destroy(encoder);
+        Assert::AreEqual(jpegls_errc::invalid_argument, error);
+    }
+
+    TEST_METHOD(get_error_histogram_too_small) // NOLINT
+    {
+        const array<uint8_t, 6> source{0, 1, 2, 3, 4, 5};
+        const charls_frame_info frame_info{3, 2, 8, 1};
+        array<uint8_t, 1024> destination{};
+
+        auto* const encoder = charls_jpegls_encoder_create();
+        auto error = charls_jpegls_encoder_set_frame_info(encoder, &frame_info);
+        Assert::AreEqual(jpegls_errc::success, error);
+        error = charls_jpegls_encoder_set_near_lossless(encoder, 1);
+        Assert::AreEqual(jpegls_errc::success, error);
+        error = charls_jpegls_encoder_set_collect_error_metrics(encoder, true);
+        Assert::AreEqual(jpegls_errc::success, error);
+        error = charls_jpegls_encoder_set_destination_buffer(encoder, destination.data(), destination.size());
+        Assert::AreEqual(jpegls_errc::success, error);
+        error = charls_jpegls_encoder_encode_from_buffer(encoder, source.data(), source.size(), 0);
+        Assert::AreEqual(jpegls_errc::success, error);
+
+        array<uint64_t, 3> histogram{};
+        const auto error1 = charls_jpegls_encoder_get_error_histogram(encoder, 0, histogram.data(), histogram.size() - 1);
+        const auto error2 = charls_jpegls_encoder_get_error_histogram(encoder, 0, histogram.data(), histogram.size());
+        charls_jpegls_encoder_destroy(encoder);
+        Assert::AreEqual(jpegls_errc::invalid_argument, error1);
+        Assert::AreEqual(jpegls_errc::success, error2);
+        Assert::AreEqual(static_cast<uint64_t>(6), histogram[0] + histogram[1] + histogram[2]);
+    }
 };
 
 } // namespace test
@@ -20,7 +20,7 @@ TEST_CLASS(ctable_test)
 public:
     TEST_METHOD(CTable_create) // NOLINT
     {
-        const CTable golomb_table;
+        const CTable<8> golomb_table;
 
         for (int i = 0; i < 256; i++)
         {
@@ -28,6 +28,21 @@ TEST_CLASS(ctable_test)
             Assert::AreEqual(0, golomb_table.Get(i).GetValue());
         }
     }
+
+    TEST_METHOD(CTable_add_entry_12_bit) // NOLINT
+    {
+        CTable<12> golomb_table;
+
+        // A code of 10 bits fills 4 entries of the 12 bit table.
+        golomb_table.AddEntry(0x155, Code(-7, 10));
+
+        for (int i = 0; i < 4; i++)
+        {
+            Assert::AreEqual(10, golomb_table.Get((0x155 << 2) + i).GetLength());
+            Assert::AreEqual(-7, golomb_table.Get((0x155 << 2) + i).GetValue());
+        }
+        Assert::AreEqual(0, golomb_table.Get((0x155 << 2) + 4).GetLength());
+    }
 };
 
 } // namespace test
@@ -8,10 +8,12 @@
 #include "encoder_strategy_tester.h"
 
 #include <array>
+#include <random>
+#include <vector>
 
 using Microsoft::VisualStudio::CppUnitTestFramework::Assert;
 using std::array;
-using std::unique_ptr;
+using std::vector;
 
 namespace {
 
@@ -19,7 +21,7 @@ class DecoderStrategyTester final : public charls::DecoderStrategy
 {
 public:
     DecoderStrategyTester(const charls::frame_info& frame_info, const charls::coding_parameters& parameters, uint8_t* const destination, const size_t nOutBufLen) : // NOLINT
-        DecoderStrategy(frame_info, parameters)
+        DecoderStrategy(frame_info, parameters, charls_allocator{})
     {
         ByteStreamInfo stream{nullptr, destination, nOutBufLen};
         Init(stream);
@@ -29,12 +31,12 @@ class DecoderStrategyTester final : public charls::DecoderStrategy
     {
     }
 
-    unique_ptr<charls::ProcessLine> CreateProcess(ByteStreamInfo /*rawStreamInfo*/, uint32_t /*stride*/) noexcept(false) override
+    charls::allocated_ptr<charls::ProcessLine> CreateProcess(ByteStreamInfo /*rawStreamInfo*/, uint32_t /*stride*/) noexcept(false) override
     {
         return nullptr;
     }
 
-    void DecodeScan(unique_ptr<charls::ProcessLine> /*outputData*/, const JlsRect& /*size*/, ByteStreamInfo& /*compressedData*/) noexcept(false) override
+    void DecodeScan(charls::allocated_ptr<charls::ProcessLine> /*outputData*/, const JlsRect& /*size*/, ByteStreamInfo& /*compressedData*/) noexcept(false) override
     {
     }
 
@@ -42,6 +44,48 @@ class DecoderStrategyTester final : public charls::DecoderStrategy
     {
         return ReadLongValue(length);
     }
+
+    int32_t ReadHighBitsForward()
+    {
+        return ReadHighBits();
+    }
+
+    int32_t PeekLeadingOnesForward()
+    {
+        return PeekLeadingOnes();
+    }
+};
+
+// Reference bit reader: reads a bit stream byte by byte and drops the stuffed 0 bit after every 0xFF byte.
+class BitStuffedReader final
+{
+public:
+    explicit BitStuffedReader(const vector<uint8_t>& data) noexcept :
+        data_{data}
+    {
+    }
+
+    int32_t Read(const int32_t length)
+    {
+        int32_t value{};
+        for (int32_t i = 0; i < length; ++i)
+        {
+            if (bitIndex_ == 0)
+            {
+                bitIndex_ = position_ > 0 && data_[position_ - 1] == 0xFF ? 7 : 8;
+                ++position_;
+            }
+
+            --bitIndex_;
+            value = (value << 1) | ((data_[position_ - 1] >> bitIndex_) & 1);
+        }
+        return value;
+    }
+
+private:
+    const vector<uint8_t>& data_;
+    size_t position_{};
+    int32_t bitIndex_{};
 };
 
 } // namespace
@@ -90,6 +134,99 @@ TEST_CLASS(DecoderStrategyTest)
             Assert::AreEqual(inData[i].value, actual);
         }
     }
+
+    TEST_METHOD(ReadHighBits) // NOLINT
+    {
+        array<uint8_t, 100> encBuf{};
+        const charls::frame_info frame_info{};
+        const charls::coding_parameters parameters{};
+
+        EncoderStrategyTester encoder(frame_info, parameters);
+
+        ByteStreamInfo stream{nullptr, encBuf.data(), encBuf.size()};
+        encoder.InitForward(stream);
+
+        encoder.AppendToBitStreamForward(1, 1);  // 0 high bits.
+        encoder.AppendToBitStreamForward(1, 6);  // 5 high bits.
+        encoder.AppendToBitStreamForward(0, 31); // 70 high bits, longer than the bit cache of the decoder.
+        encoder.AppendToBitStreamForward(0, 31);
+        encoder.AppendToBitStreamForward(1, 9);
+        encoder.AppendToBitStreamForward(5, 3);
+        encoder.EndScanForward();
+
+        const auto length = encoder.GetLengthForward();
+        DecoderStrategyTester dec(frame_info, parameters, encBuf.data(), length);
+        Assert::AreEqual(0, dec.ReadHighBitsForward());
+        Assert::AreEqual(5, dec.ReadHighBitsForward());
+        Assert::AreEqual(70, dec.ReadHighBitsForward());
+        Assert::AreEqual(5, dec.Read(3));
+    }
+
+    TEST_METHOD(PeekLeadingOnes) // NOLINT
+    {
+        array<uint8_t, 100> encBuf{};
+        const charls::frame_info frame_info{};
+        const charls::coding_parameters parameters{};
+
+        EncoderStrategyTester encoder(frame_info, parameters);
+
+        ByteStreamInfo stream{nullptr, encBuf.data(), encBuf.size()};
+        encoder.InitForward(stream);
+
+        encoder.AppendToBitStreamForward(0, 1);     // 0 leading ones.
+        encoder.AppendToBitStreamForward(0x3E, 6);  // 5 leading ones.
+        encoder.AppendToBitStreamForward(0x7FFFFFFF, 31);
+        encoder.AppendToBitStreamForward(0x7FFFFFFF, 31);
+        encoder.AppendToBitStreamForward(0, 1);
+        encoder.EndScanForward();
+
+        const auto length = encoder.GetLengthForward();
+        DecoderStrategyTester dec(frame_info, parameters, encBuf.data(), length);
+        Assert::AreEqual(0, dec.PeekLeadingOnesForward());
+        Assert::AreEqual(0, dec.Read(1));
+        Assert::AreEqual(5, dec.PeekLeadingOnesForward());
+        Assert::AreEqual(0x3E, dec.Read(6));
+
+        // 62 ones: more than the valid bits in the cache, the count is limited to the valid bits.
+        const int32_t count = dec.PeekLeadingOnesForward();
+        Assert::IsTrue(count >= 16 && count < 62);
+        Assert::AreEqual(0xFFFF, dec.Read(16));
+    }
+
+    TEST_METHOD(ReadWithManyStuffedBits) // NOLINT
+    {
+        // Bit streams with 1, 2 or more 0xFF bytes in every 8 byte window take the bulk refill path,
+        // which must give the same bits as reading byte by byte.
+        std::mt19937 generator{42};
+        for (const uint32_t period : {2U, 3U, 5U, 8U})
+        {
+            vector<uint8_t> data(1000);
+            for (size_t i = 0; i < data.size(); ++i)
+            {
+                if (i > 0 && data[i - 1] == 0xFF)
+                {
+                    data[i] = static_cast<uint8_t>(generator() % 0x80); // JPEG bit stream rule: 0xFF is followed by a byte < 0x80.
+                }
+                else
+                {
+                    data[i] = generator() % period == 0 ? 0xFF : static_cast<uint8_t>(generator());
+                }
+            }
+            data.back() = 0;
+
+            const charls::frame_info frame_info{};
+            const charls::coding_parameters parameters{};
+            DecoderStrategyTester decoder(frame_info, parameters, data.data(), data.size());
+            BitStuffedReader reference(data);
+
+            // Read values with varying lengths to start the refills at every bit position.
+            for (int32_t i = 0; i < 400; ++i)
+            {
+                const int32_t length = static_cast<int32_t>(generator() % 16) + 1;
+                Assert::AreEqual(reference.Read(length), decoder.Read(length));
+            }
+        }
+    }
 };
 
 } // namespace test
@@ -55,7 +55,7 @@ TEST_CLASS(EncoderStrategyTest)
         strategy.AppendToBitStreamForward(0xffff, 16);
         strategy.AppendToBitStreamForward(0xffff, 16);
 
-        // Buffer is full with FFs and _isFFWritten = true: Flush can only write 30 date bits.
+        // Buffer contains FFs and _isFFWritten = true: Flush needs to insert marker detect bits.
         strategy.AppendToBitStreamForward(0x3, 31);
 
         strategy.FlushForward();
@@ -77,6 +77,38 @@ TEST_CLASS(EncoderStrategyTest)
         Assert::AreEqual(static_cast<uint8_t>(0xC0), data[12]);
         Assert::AreEqual(static_cast<uint8_t>(0x77), data[13]);
     }
+
+    TEST_METHOD(AppendToBitStreamWithoutFF) // NOLINT
+    {
+        const charls::frame_info frame_info{};
+        const charls::coding_parameters parameters{};
+
+        EncoderStrategyTester strategy(frame_info, parameters);
+
+        array<uint8_t, 1024> data{};
+        data[12] = 0x77; // marker byte to detect overruns.
+
+        ByteStreamInfo stream{nullptr, data.data(), data.size()};
+        strategy.InitForward(stream);
+
+        // 96 bits without a 0xFF byte: the first 64 bits are flushed as a single big endian word.
+        for (int i = 0; i < 4; ++i)
+        {
+            strategy.AppendToBitStreamForward(0x123456, 24);
+        }
+
+        strategy.FlushForward();
+
+        // Verify output.
+        Assert::AreEqual(static_cast<size_t>(12), strategy.GetLengthForward());
+        for (int i = 0; i < 12; i += 3)
+        {
+            Assert::AreEqual(static_cast<uint8_t>(0x12), data[i]);
+            Assert::AreEqual(static_cast<uint8_t>(0x34), data[i + 1]);
+            Assert::AreEqual(static_cast<uint8_t>(0x56), data[i + 2]);
+        }
+        Assert::AreEqual(static_cast<uint8_t>(0x77), data[12]);
+    }
 };
 
 } // namespace test
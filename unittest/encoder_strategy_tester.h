@@ -12,7 +12,7 @@ class EncoderStrategyTester final : charls::EncoderStrategy
 {
 public:
     explicit EncoderStrategyTester(const charls::frame_info& frame_info, const charls::coding_parameters& parameters) :
-        EncoderStrategy(frame_info, parameters)
+        EncoderStrategy(frame_info, parameters, charls_allocator{})
     {
     }
 
@@ -20,12 +20,12 @@ class EncoderStrategyTester final : charls::EncoderStrategy
     {
     }
 
-    size_t EncodeScan(std::unique_ptr<charls::ProcessLine>, ByteStreamInfo&) noexcept(false) override
+    size_t EncodeScan(charls::allocated_ptr<charls::ProcessLine>, ByteStreamInfo&) noexcept(false) override
     {
         return 0;
     }
 
-    std::unique_ptr<charls::ProcessLine> CreateProcess(ByteStreamInfo, uint32_t /*stride*/) noexcept(false) override
+    charls::allocated_ptr<charls::ProcessLine> CreateProcess(ByteStreamInfo, uint32_t /*stride*/) noexcept(false) override
     {
         return nullptr;
     }
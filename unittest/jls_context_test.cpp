@@ -0,0 +1,59 @@
+// Copyright (c) Team CharLS.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "pch.h"
+
+#include "../src/context.h"
+
+using Microsoft::VisualStudio::CppUnitTestFramework::Assert;
+
+namespace charls {
+namespace test {
+
+namespace {
+
+int32_t GetGolombReference(const int32_t n, const int32_t a) noexcept
+{
+    int32_t k = 0;
+    for (; (n << k) < a; ++k)
+    {
+    }
+    return k;
+}
+
+} // namespace
+
+// clang-format off
+
+TEST_CLASS(jls_context_test)
+{
+public:
+    TEST_METHOD(GetGolomb) // NOLINT
+    {
+        for (int32_t n = 1; n <= 256; ++n)
+        {
+            for (int32_t a = 1; a < 65536 * 256; a = a * 3 / 2 + 1)
+            {
+                JlsContext context(a);
+                context.N = static_cast<int16_t>(n);
+
+                Assert::AreEqual(GetGolombReference(n, a), context.GetGolomb());
+            }
+        }
+    }
+
+    TEST_METHOD(UpdateVariablesKeepsBInRange) // NOLINT
+    {
+        JlsContext context(4);
+
+        for (int32_t i = 0; i < 1000; ++i)
+        {
+            context.UpdateVariables(i % 2 == 0 ? -255 : 3, 0, 64);
+
+            Assert::IsTrue(context.B <= 0 && context.B > -context.N);
+        }
+    }
+};
+
+} // namespace test
+} // namespace charls
@@ -161,6 +161,55 @@ TEST_CLASS(JpegStreamReaderTest)
         Assert::AreEqual(presets.threshold3, actual.threshold3);
     }
 
+    TEST_METHOD(ReadHeaderDefineRestartIntervalSegment) // NOLINT
+    {
+        vector<uint8_t> source(100);
+        const ByteStreamInfo sourceInfo = FromByteArray(source.data(), source.size());
+
+        charls::JpegStreamWriter writer(sourceInfo);
+        writer.WriteStartOfImage();
+        writer.WriteStartOfFrameSegment(1, 1, 2, 1);
+        writer.WriteDefineRestartIntervalSegment(0x1000000);
+        writer.WriteStartOfScanSegment(1, 0, interleave_mode::none);
+
+        const ByteStreamInfo destinationInfo = FromByteArray(source.data(), source.size());
+        JpegStreamReader reader(destinationInfo);
+
+        reader.ReadHeader();
+
+        Assert::AreEqual(0x1000000U, reader.parameters().restart_interval);
+    }
+
+    TEST_METHOD(ReadHeaderWithBadSizeDefineRestartIntervalSegmentShouldThrow) // NOLINT
+    {
+        JpegTestStreamWriter writer;
+        writer.WriteStartOfImage();
+        writer.WriteStartOfFrameSegment(1, 1, 2, 1);
+
+        writer.buffer.push_back(0xFF);
+        writer.buffer.push_back(0xDD); // DRI: Define restart interval.
+        writer.buffer.push_back(0x00);
+        writer.buffer.push_back(0x03);
+        writer.buffer.push_back(0x01);
+
+        writer.WriteStartOfScanSegment(0, 1, 0, charls::interleave_mode::none);
+
+        const ByteStreamInfo byteStream = FromByteArray(writer.buffer.data(), writer.buffer.size());
+        JpegStreamReader reader(byteStream);
+
+        try
+        {
+            reader.ReadHeader();
+        }
+        catch (const system_error& error)
+        {
+            Assert::AreEqual(static_cast<int>(jpegls_errc::invalid_marker_segment_size), error.code().value());
+            return;
+        }
+
+        Assert::Fail();
+    }
+
     TEST_METHOD(ReadHeaderWithTooSmallJpegLSPresetParameterSegmentShouldThrow) // NOLINT
     {
         vector<uint8_t> buffer;
@@ -328,6 +328,38 @@ TEST_CLASS(JpegStreamWriterTest)
         Assert::AreEqual(static_cast<uint8_t>(0), buffer[8]); // ILV parameter.
         Assert::AreEqual(static_cast<uint8_t>(0), buffer[9]); // transformation.
     }
+
+    TEST_METHOD(WriteDefineRestartIntervalSegment) // NOLINT
+    {
+        array<uint8_t, 6> buffer{};
+        const ByteStreamInfo info = FromByteArray(buffer.data(), buffer.size());
+        JpegStreamWriter writer(info);
+
+        writer.WriteDefineRestartIntervalSegment(0x1234);
+
+        Assert::AreEqual(buffer.size(), writer.GetBytesWritten());
+        Assert::AreEqual(static_cast<uint8_t>(0xFF), buffer[0]);
+        Assert::AreEqual(static_cast<uint8_t>(0xDD), buffer[1]); // DRI marker.
+        Assert::AreEqual(static_cast<uint8_t>(0), buffer[2]);
+        Assert::AreEqual(static_cast<uint8_t>(4), buffer[3]); // length.
+        Assert::AreEqual(static_cast<uint8_t>(0x12), buffer[4]);
+        Assert::AreEqual(static_cast<uint8_t>(0x34), buffer[5]);
+    }
+
+    TEST_METHOD(WriteDefineRestartIntervalSegmentWith3ByteInterval) // NOLINT
+    {
+        array<uint8_t, 7> buffer{};
+        const ByteStreamInfo info = FromByteArray(buffer.data(), buffer.size());
+        JpegStreamWriter writer(info);
+
+        writer.WriteDefineRestartIntervalSegment(0x123456);
+
+        Assert::AreEqual(buffer.size(), writer.GetBytesWritten());
+        Assert::AreEqual(static_cast<uint8_t>(5), buffer[3]); // length.
+        Assert::AreEqual(static_cast<uint8_t>(0x12), buffer[4]);
+        Assert::AreEqual(static_cast<uint8_t>(0x34), buffer[5]);
+        Assert::AreEqual(static_cast<uint8_t>(0x56), buffer[6]);
+    }
 };
 
 } // namespace test
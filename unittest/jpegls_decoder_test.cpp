@@ -7,7 +7,9 @@
 
 #include <charls/charls.h>
 
+#include <algorithm>
 #include <array>
+#include <random>
 #include <tuple>
 #include <vector>
 
@@ -377,6 +379,313 @@ TEST_CLASS(jpegls_decoder_test)
         Assert::AreEqual(expected_size, decoded_destination.size() * sizeof(uint16_t));
     }
 
+    TEST_METHOD(decode_with_multiple_threads) // NOLINT
+    {
+        const vector<uint8_t> source{read_file("DataFiles/T8C0E0.JLS")};
+
+        jpegls_decoder decoder1{source};
+        decoder1.read_header();
+        Assert::AreEqual(interleave_mode::none, decoder1.interleave_mode());
+        vector<uint8_t> destination1(decoder1.destination_size());
+        decoder1.decode(destination1);
+
+        jpegls_decoder decoder2{source};
+        decoder2.maximum_thread_count(3).read_header();
+        vector<uint8_t> destination2(decoder2.destination_size());
+        decoder2.decode(destination2);
+
+        Assert::IsTrue(destination1 == destination2);
+    }
+
+    TEST_METHOD(decode_near_lossless_with_all_hardware_threads) // NOLINT
+    {
+        const vector<uint8_t> source{read_file("DataFiles/T8C0E3.JLS")};
+
+        jpegls_decoder decoder1{source};
+        decoder1.read_header();
+        vector<uint8_t> destination1(decoder1.destination_size());
+        decoder1.decode(destination1);
+
+        jpegls_decoder decoder2{source};
+        decoder2.maximum_thread_count(0).read_header();
+        vector<uint8_t> destination2(decoder2.destination_size());
+        decoder2.decode(destination2);
+
+        Assert::IsTrue(destination1 == destination2);
+    }
+
+    TEST_METHOD(decode_restart_intervals_with_multiple_threads) // NOLINT
+    {
+        const vector<uint8_t> source{read_file("DataFiles/T8C1E0.JLS")};
+
+        jpegls_decoder decoder1{source};
+        decoder1.read_header();
+        vector<uint8_t> destination1(decoder1.destination_size());
+        decoder1.decode(destination1);
+
+        jpegls_encoder encoder;
+        encoder.frame_info(decoder1.frame_info()).interleave_mode(decoder1.interleave_mode()).restart_interval(7);
+        vector<uint8_t> encoded(encoder.estimated_destination_size());
+        encoder.destination(encoded);
+        encoded.resize(encoder.encode(destination1));
+
+        jpegls_decoder decoder2{encoded};
+        decoder2.maximum_thread_count(4).read_header();
+        vector<uint8_t> destination2(decoder2.destination_size());
+        decoder2.decode(destination2);
+
+        Assert::IsTrue(destination1 == destination2);
+    }
+
+    TEST_METHOD(decode_truncated_stream_with_multiple_threads) // NOLINT
+    {
+        const vector<uint8_t> source{read_file("DataFiles/T8C1E0.JLS")};
+        const vector<uint8_t> truncated_source(source.begin(), source.begin() + static_cast<ptrdiff_t>(source.size() / 2));
+
+        jpegls_decoder decoder{truncated_source};
+        decoder.maximum_thread_count(2).read_header();
+        Assert::AreEqual(interleave_mode::line, decoder.interleave_mode());
+        vector<uint8_t> destination(decoder.destination_size());
+
+        assert_expect_exception(jpegls_errc::invalid_encoded_data,
+            [&] { static_cast<void>(decoder.decode(destination)); });
+
+        // After the failure the decoded lines are no longer written to the destination and the decoder can be reused.
+        std::fill(destination.begin(), destination.end(), static_cast<uint8_t>(0x5A));
+        decoder.reset().source(source).read_header();
+        vector<uint8_t> destination2(decoder.destination_size());
+        decoder.decode(destination2);
+
+        jpegls_decoder decoder2{source};
+        decoder2.read_header();
+        vector<uint8_t> expected(decoder2.destination_size());
+        decoder2.decode(expected);
+
+        Assert::IsTrue(expected == destination2);
+        Assert::IsTrue(std::all_of(destination.cbegin(), destination.cend(), [](const uint8_t value) { return value == 0x5A; }));
+    }
+
+    TEST_METHOD(decode_corrupt_stream_with_ff_bytes) // NOLINT
+    {
+        // Overwriting the entropy coded data with 0xFF 0x7F makes the decoder consume more bits than are valid,
+        // which must be reported as an error (or decode to garbage) without reading outside the stream.
+        for (const int32_t bits_per_sample : {8, 12})
+        {
+            constexpr uint32_t width{64};
+            constexpr uint32_t height{64};
+            vector<uint8_t> source(static_cast<size_t>(width) * height * (bits_per_sample > 8 ? 2 : 1));
+            std::mt19937 generator{42};
+            for (size_t i = 0; i < source.size(); ++i)
+            {
+                source[i] = static_cast<uint8_t>(generator() & (bits_per_sample > 8 && i % 2 == 1 ? 0x0F : 0xFF));
+            }
+
+            jpegls_encoder encoder;
+            encoder.frame_info({width, height, bits_per_sample, 1});
+            vector<uint8_t> encoded(encoder.estimated_destination_size());
+            encoder.destination(encoded);
+            encoded.resize(encoder.encode(source));
+
+            int32_t error_count{};
+            for (size_t position = 40; position + 2 < encoded.size(); position += 7)
+            {
+                vector<uint8_t> corrupt_source{encoded};
+                corrupt_source[position] = 0xFF;
+                corrupt_source[position + 1] = 0x7F;
+
+                try
+                {
+                    jpegls_decoder decoder{corrupt_source};
+                    decoder.read_header();
+                    vector<uint8_t> destination(decoder.destination_size());
+                    decoder.decode(destination);
+                }
+                catch (const jpegls_error&)
+                {
+                    ++error_count;
+                }
+            }
+
+            Assert::IsTrue(error_count > 0);
+        }
+    }
+
+    TEST_METHOD(decode_image_with_long_runs) // NOLINT
+    {
+        // Runs of many segments that end in the middle of a line and at the end of a line.
+        constexpr uint32_t width{1000};
+        constexpr uint32_t height{4};
+        for (const int32_t component_count : {1, 3})
+        {
+            vector<uint8_t> source(static_cast<size_t>(width) * height * component_count);
+            for (size_t i = 0; i < source.size(); ++i)
+            {
+                const size_t pixel = i / component_count;
+                source[i] = static_cast<uint8_t>((pixel % width) < 700 ? 10 + i % component_count : pixel / width);
+            }
+
+            jpegls_encoder encoder;
+            encoder.frame_info({width, height, 8, component_count}).interleave_mode(component_count == 1 ? interleave_mode::none : interleave_mode::sample);
+            vector<uint8_t> encoded(encoder.estimated_destination_size());
+            encoder.destination(encoded);
+            encoded.resize(encoder.encode(source));
+
+            jpegls_decoder decoder{encoded};
+            decoder.read_header();
+            vector<uint8_t> destination(decoder.destination_size());
+            decoder.decode(destination);
+
+            Assert::IsTrue(source == destination);
+        }
+    }
+
+    TEST_METHOD(decode_single_component_in_place) // NOLINT
+    {
+        // Single component lines are decoded in place when the destination is aligned for the samples.
+        // A destination at an odd address is decoded with the line buffers: both must be identical.
+        constexpr uint32_t width{31};
+        constexpr uint32_t height{9};
+        constexpr uint32_t stride{(width + 3) * sizeof(uint16_t)};
+        vector<uint8_t> source(static_cast<size_t>(width) * height * sizeof(uint16_t));
+        for (size_t i = 0; i < source.size(); i += 2)
+        {
+            const size_t pixel = i / 2;
+            const uint16_t value = static_cast<uint16_t>((pixel % width) < 12 ? 100 : (pixel * 7919) % 4096);
+            source[i] = static_cast<uint8_t>(value);
+            source[i + 1] = static_cast<uint8_t>(value >> 8);
+        }
+
+        for (const int32_t near_lossless : {0, 3})
+        {
+            jpegls_encoder encoder;
+            encoder.frame_info({width, height, 12, 1}).near_lossless(near_lossless).restart_interval(4);
+            vector<uint8_t> encoded(encoder.estimated_destination_size());
+            encoder.destination(encoded);
+            encoded.resize(encoder.encode(source));
+
+            jpegls_decoder decoder{encoded};
+            decoder.read_header();
+            vector<uint16_t> in_place(static_cast<size_t>(stride) * height / sizeof(uint16_t));
+            decoder.decode(in_place.data(), in_place.size() * sizeof(uint16_t), stride);
+
+            jpegls_decoder decoder_line_buffers{encoded};
+            decoder_line_buffers.read_header();
+            vector<uint8_t> line_buffers(static_cast<size_t>(stride) * height + 1);
+            decoder_line_buffers.decode(line_buffers.data() + 1, line_buffers.size() - 1, stride);
+
+            for (uint32_t line = 0; line < height; ++line)
+            {
+                const auto* in_place_line = reinterpret_cast<const uint8_t*>(in_place.data()) + static_cast<size_t>(line) * stride;
+                const auto* line_buffers_line = line_buffers.data() + 1 + static_cast<size_t>(line) * stride;
+                Assert::IsTrue(std::equal(in_place_line, in_place_line + width * sizeof(uint16_t), line_buffers_line));
+                if (near_lossless == 0)
+                {
+                    Assert::IsTrue(std::equal(in_place_line, in_place_line + width * sizeof(uint16_t), source.data() + static_cast<size_t>(line) * width * sizeof(uint16_t)));
+                }
+            }
+        }
+    }
+
+    TEST_METHOD(decode_after_reset) // NOLINT
+    {
+        // A reset decoder reuses the codec of the previous image when the frame info and coding parameters match.
+        const auto create_source = [](const uint32_t width, const uint32_t height, const int32_t component_count, const size_t seed) {
+            vector<uint8_t> source(static_cast<size_t>(width) * height * component_count);
+            for (size_t i = 0; i < source.size(); ++i)
+            {
+                source[i] = static_cast<uint8_t>((i * seed) / 5 + (i % 13) * 11);
+            }
+            return source;
+        };
+        const auto encode = [](const vector<uint8_t>& source, const frame_info& frame_info) {
+            jpegls_encoder encoder;
+            encoder.frame_info(frame_info).interleave_mode(frame_info.component_count == 1 ? interleave_mode::none : interleave_mode::line);
+            vector<uint8_t> encoded(encoder.estimated_destination_size());
+            encoder.destination(encoded);
+            encoded.resize(encoder.encode(source));
+            return encoded;
+        };
+
+        const frame_info color_frame_info{64, 30, 8, 3};
+        const frame_info monochrome_frame_info{33, 17, 8, 1};
+        const vector<vector<uint8_t>> sources{create_source(64, 30, 3, 7), create_source(64, 30, 3, 3), create_source(33, 17, 1, 7)};
+        const vector<vector<uint8_t>> encoded{encode(sources[0], color_frame_info), encode(sources[1], color_frame_info),
+                                              encode(sources[2], monochrome_frame_info)};
+
+        jpegls_decoder decoder;
+        for (size_t i = 0; i < encoded.size(); ++i)
+        {
+            decoder.reset().source(encoded[i]).read_header();
+            vector<uint8_t> destination(decoder.destination_size());
+            decoder.decode(destination);
+
+            Assert::IsTrue(sources[i] == destination);
+        }
+    }
+
+    TEST_METHOD(decode_with_allocator) // NOLINT
+    {
+        vector<uint8_t> source(static_cast<size_t>(64) * 30 * 3);
+        for (size_t i = 0; i < source.size(); ++i)
+        {
+            source[i] = static_cast<uint8_t>(i * 7 / 3 + (i % 11) * 13);
+        }
+        const vector<uint8_t> encoded{jpegls_encoder::encode(source, {64, 30, 8, 3}, interleave_mode::sample)};
+
+        counting_allocator allocator;
+        jpegls_decoder decoder;
+        decoder.allocator(allocator.allocator()).source(encoded).read_header();
+        vector<uint8_t> destination(decoder.destination_size());
+        decoder.decode(destination);
+
+        Assert::IsTrue(source == destination);
+        Assert::IsTrue(allocator.allocation_count > 0);
+        Assert::IsTrue(allocator.bytes_in_use > 0);
+
+        // Replacing the allocator releases the memory that was allocated with it.
+        decoder.allocator({});
+        Assert::AreEqual(size_t{0}, allocator.bytes_in_use);
+    }
+
+    TEST_METHOD(decode_with_allocator_and_multiple_threads) // NOLINT
+    {
+        // The decoded lines are passed to a helper thread through line buffers, which must also use the allocator.
+        vector<uint8_t> source(static_cast<size_t>(64) * 30 * 3);
+        for (size_t i = 0; i < source.size(); ++i)
+        {
+            source[i] = static_cast<uint8_t>(i * 7 / 3 + (i % 11) * 13);
+        }
+        const vector<uint8_t> encoded{jpegls_encoder::encode(source, {64, 30, 8, 3}, interleave_mode::sample)};
+
+        counting_allocator allocator;
+        jpegls_decoder decoder;
+        decoder.allocator(allocator.allocator()).maximum_thread_count(2).source(encoded).read_header();
+        vector<uint8_t> destination(decoder.destination_size());
+        decoder.decode(destination);
+
+        Assert::IsTrue(source == destination);
+        decoder.allocator({});
+        Assert::AreEqual(size_t{0}, allocator.bytes_in_use);
+    }
+
+    TEST_METHOD(set_source_twice_without_reset_throws) // NOLINT
+    {
+        const array<uint8_t, 10> source{};
+        jpegls_decoder decoder;
+        decoder.source(source.data(), source.size());
+
+        assert_expect_exception(jpegls_errc::invalid_operation,
+            [&] { static_cast<void>(decoder.source(source.data(), source.size())); });
+    }
+
+    TEST_METHOD(maximum_thread_count_negative_throws) // NOLINT
+    {
+        jpegls_decoder decoder;
+
+        assert_expect_exception(jpegls_errc::invalid_argument,
+            [&] { static_cast<void>(decoder.maximum_thread_count(-1)); });
+    }
+
     TEST_METHOD(decode_file_with_ff_in_entropy_data) // NOLINT
     {
         const vector<uint8_t> source{read_file("ff_in_entropy_data.jls")};
@@ -8,7 +8,11 @@
 #include "../src/jpeg_marker_code.h"
 #include <charls/charls.h>
 
+#include <algorithm>
 #include <array>
+#include <cmath>
+#include <cstring>
+#include <random>
 #include <vector>
 
 using Microsoft::VisualStudio::CppUnitTestFramework::Assert;
@@ -517,6 +521,533 @@ TEST_CLASS(jpegls_encoder_test)
         test_by_decoding(destination, frame_info, source.data(), source.size(), interleave_mode::none);
     }
 
+    TEST_METHOD(encode_10bit_sample_interleaved) // NOLINT
+    {
+        // Values near the maximum sample value and equal pixels cover the regular and run mode of the 10 bit pixel codec.
+        vector<uint16_t> pixels(static_cast<size_t>(16) * 4 * 3);
+        for (size_t i = 0; i < pixels.size(); ++i)
+        {
+            pixels[i] = static_cast<uint16_t>(i % 7 == 0 ? 1023 : (i / 3) % 5 * 200);
+        }
+        vector<uint8_t> source(pixels.size() * sizeof(uint16_t));
+        memcpy(source.data(), pixels.data(), source.size());
+        const frame_info frame_info{16, 4, 10, 3};
+
+        jpegls_encoder encoder;
+        encoder.frame_info(frame_info).interleave_mode(interleave_mode::sample);
+        vector<uint8_t> destination(encoder.estimated_destination_size());
+        encoder.destination(destination);
+        destination.resize(encoder.encode(source));
+
+        test_by_decoding(destination, frame_info, source.data(), source.size(), interleave_mode::sample);
+    }
+
+    TEST_METHOD(encode_4_components_sample_interleaved_with_alpha_changes) // NOLINT
+    {
+        // Equal color values with a changing alpha value: the alpha value must end a run.
+        vector<uint8_t> source(static_cast<size_t>(32) * 2 * 4, 100);
+        for (size_t i = 3; i < source.size(); i += 4)
+        {
+            source[i] = static_cast<uint8_t>(i / 24);
+        }
+        const frame_info frame_info{32, 2, 8, 4};
+
+        jpegls_encoder encoder;
+        encoder.frame_info(frame_info).interleave_mode(interleave_mode::sample);
+        vector<uint8_t> destination(encoder.estimated_destination_size());
+        encoder.destination(destination);
+        destination.resize(encoder.encode(source));
+
+        test_by_decoding(destination, frame_info, source.data(), source.size(), interleave_mode::sample);
+    }
+
+    TEST_METHOD(encode_with_multiple_threads) // NOLINT
+    {
+        const vector<uint8_t> source{0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23};
+        const frame_info frame_info{3, 2, 8, 4};
+
+        jpegls_encoder encoder1;
+        encoder1.frame_info(frame_info);
+        vector<uint8_t> destination1(encoder1.estimated_destination_size());
+        encoder1.destination(destination1);
+        destination1.resize(encoder1.encode(source));
+
+        jpegls_encoder encoder2;
+        encoder2.frame_info(frame_info).maximum_thread_count(4);
+        vector<uint8_t> destination2(encoder2.estimated_destination_size());
+        encoder2.destination(destination2);
+        destination2.resize(encoder2.encode(source));
+
+        Assert::IsTrue(destination1 == destination2);
+        test_by_decoding(destination2, frame_info, source.data(), source.size(), interleave_mode::none);
+    }
+
+    TEST_METHOD(encode_noise_with_multiple_threads) // NOLINT
+    {
+        // Noise doesn't compress: the scans encoded in scratch buffers are larger than their initial size.
+        vector<uint8_t> source(static_cast<size_t>(256) * 256 * 3);
+        uint32_t random{1};
+        for (auto& sample : source)
+        {
+            random = random * 1103515245 + 12345;
+            sample = static_cast<uint8_t>(random >> 16);
+        }
+        const frame_info frame_info{256, 256, 8, 3};
+
+        jpegls_encoder encoder1;
+        encoder1.frame_info(frame_info);
+        vector<uint8_t> destination1(encoder1.estimated_destination_size() * 2);
+        encoder1.destination(destination1);
+        destination1.resize(encoder1.encode(source));
+
+        jpegls_encoder encoder2;
+        encoder2.frame_info(frame_info).maximum_thread_count(3);
+        vector<uint8_t> destination2(encoder2.estimated_destination_size() * 2);
+        encoder2.destination(destination2);
+        destination2.resize(encoder2.encode(source));
+
+        Assert::IsTrue(destination1 == destination2);
+        test_by_decoding(destination2, frame_info, source.data(), source.size(), interleave_mode::none);
+    }
+
+    TEST_METHOD(encode_to_too_small_destination_with_multiple_threads) // NOLINT
+    {
+        const vector<uint8_t> source{create_test_image(64, 30, 3)};
+        const frame_info frame_info{64, 30, 8, 3};
+
+        jpegls_encoder encoder;
+        encoder.frame_info(frame_info).interleave_mode(interleave_mode::sample).maximum_thread_count(2);
+        vector<uint8_t> destination(100);
+        encoder.destination(destination);
+
+        assert_expect_exception(jpegls_errc::destination_buffer_too_small,
+                                [&] { static_cast<void>(encoder.encode(source)); });
+
+        // After the failure the source is no longer read and the encoder can be reused.
+        encoder.reset().frame_info(frame_info).interleave_mode(interleave_mode::sample).maximum_thread_count(2);
+        destination.resize(encoder.estimated_destination_size());
+        encoder.destination(destination);
+        destination.resize(encoder.encode(source));
+
+        test_by_decoding(destination, frame_info, source.data(), source.size(), interleave_mode::sample);
+    }
+
+    TEST_METHOD(encode_with_restart_interval) // NOLINT
+    {
+        const vector<uint8_t> source{0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23};
+        const frame_info frame_info{3, 8, 8, 1};
+
+        jpegls_encoder encoder;
+        encoder.frame_info(frame_info).restart_interval(3);
+        vector<uint8_t> destination(encoder.estimated_destination_size());
+        encoder.destination(destination);
+        destination.resize(encoder.encode(source));
+
+        // 8 lines with an interval of 3 lines: the scan contains the restart markers RST0 and RST1.
+        Assert::AreEqual(1, count_marker(destination, 0xD0));
+        Assert::AreEqual(1, count_marker(destination, 0xD1));
+        Assert::AreEqual(0, count_marker(destination, 0xD2));
+
+        test_by_decoding(destination, frame_info, source.data(), source.size(), interleave_mode::none);
+    }
+
+    TEST_METHOD(encode_noise_with_small_restart_interval) // NOLINT
+    {
+        // The contexts are reset at every interval, which makes noise more expensive to encode: it must still fit
+        // in the estimated destination size.
+        const array<std::pair<frame_info, charls::interleave_mode>, 3> images{{{{257, 33, 8, 1}, interleave_mode::none},
+                                                                      {{64, 16, 8, 3}, interleave_mode::none},
+                                                                      {{64, 16, 8, 3}, interleave_mode::sample}}};
+        std::mt19937 generator{42};
+        for (const auto& image : images)
+        {
+            vector<uint8_t> source(static_cast<size_t>(image.first.width) * image.first.height * image.first.component_count);
+            for (auto& sample : source)
+            {
+                sample = static_cast<uint8_t>(generator());
+            }
+
+            jpegls_encoder encoder;
+            encoder.frame_info(image.first).interleave_mode(image.second).restart_interval(3);
+            vector<uint8_t> destination(encoder.estimated_destination_size());
+            encoder.destination(destination);
+            destination.resize(encoder.encode(source));
+
+            test_by_decoding(destination, image.first, source.data(), source.size(), image.second);
+        }
+    }
+
+    TEST_METHOD(encode_restart_intervals_with_multiple_threads) // NOLINT
+    {
+        vector<uint8_t> source(static_cast<size_t>(64) * 30 * 3);
+        for (size_t i = 0; i < source.size(); ++i)
+        {
+            source[i] = static_cast<uint8_t>(i * 7 / 3);
+        }
+        const frame_info frame_info{64, 30, 8, 3};
+
+        jpegls_encoder encoder1;
+        encoder1.frame_info(frame_info).interleave_mode(interleave_mode::sample).restart_interval(4);
+        vector<uint8_t> destination1(encoder1.estimated_destination_size());
+        encoder1.destination(destination1);
+        destination1.resize(encoder1.encode(source));
+
+        jpegls_encoder encoder2;
+        encoder2.frame_info(frame_info).interleave_mode(interleave_mode::sample).restart_interval(4).maximum_thread_count(3);
+        vector<uint8_t> destination2(encoder2.estimated_destination_size());
+        encoder2.destination(destination2);
+        destination2.resize(encoder2.encode(source));
+
+        Assert::IsTrue(destination1 == destination2);
+        test_by_decoding(destination2, frame_info, source.data(), source.size(), interleave_mode::sample);
+    }
+
+    TEST_METHOD(encode_restart_interval_of_one_line_with_multiple_threads) // NOLINT
+    {
+        // 100 intervals in 8 stripes: the stripes contain multiple intervals and start with different RSTm markers.
+        vector<uint8_t> source(static_cast<size_t>(64) * 100);
+        for (size_t i = 0; i < source.size(); ++i)
+        {
+            source[i] = static_cast<uint8_t>(i * 7 / 3);
+        }
+        const frame_info frame_info{64, 100, 8, 1};
+
+        jpegls_encoder encoder1;
+        encoder1.frame_info(frame_info).restart_interval(1);
+        vector<uint8_t> destination1(encoder1.estimated_destination_size());
+        encoder1.destination(destination1);
+        destination1.resize(encoder1.encode(source));
+
+        jpegls_encoder encoder2;
+        encoder2.frame_info(frame_info).restart_interval(1).maximum_thread_count(2);
+        vector<uint8_t> destination2(encoder2.estimated_destination_size());
+        encoder2.destination(destination2);
+        destination2.resize(encoder2.encode(source));
+
+        Assert::IsTrue(destination1 == destination2);
+        test_by_decoding(destination2, frame_info, source.data(), source.size(), interleave_mode::none);
+    }
+
+    TEST_METHOD(encode_single_component_in_place) // NOLINT
+    {
+        // Lossless 16 bit lines are read in place when the source is aligned for the samples.
+        // A source at an odd address is copied to the line buffers: both must produce the same bit stream.
+        constexpr uint32_t width{29};
+        constexpr uint32_t height{11};
+        vector<uint16_t> source(static_cast<size_t>(width) * height);
+        for (size_t i = 0; i < source.size(); ++i)
+        {
+            source[i] = static_cast<uint16_t>((i % width) < 10 ? 1000 : i * 7919);
+        }
+        const size_t source_size = source.size() * sizeof(uint16_t);
+        vector<uint8_t> unaligned_source(source_size + 1);
+        memcpy(unaligned_source.data() + 1, source.data(), source_size);
+        const frame_info frame_info{width, height, 16, 1};
+
+        jpegls_encoder encoder1;
+        encoder1.frame_info(frame_info).restart_interval(4);
+        vector<uint8_t> destination1(encoder1.estimated_destination_size());
+        encoder1.destination(destination1);
+        destination1.resize(encoder1.encode(source.data(), source_size));
+
+        jpegls_encoder encoder2;
+        encoder2.frame_info(frame_info).restart_interval(4);
+        vector<uint8_t> destination2(encoder2.estimated_destination_size());
+        encoder2.destination(destination2);
+        destination2.resize(encoder2.encode(unaligned_source.data() + 1, source_size));
+
+        Assert::IsTrue(destination1 == destination2);
+        test_by_decoding(destination1, frame_info, reinterpret_cast<const uint8_t*>(source.data()), source_size, interleave_mode::none);
+    }
+
+    TEST_METHOD(encode_after_reset) // NOLINT
+    {
+        // A reset encoder reuses the codec of the previous image: the result must be identical to a new encoder.
+        const vector<uint8_t> source1{create_test_image(64, 30, 3)};
+        vector<uint8_t> source2{create_test_image(64, 30, 3)};
+        std::reverse(source2.begin(), source2.end());
+        const frame_info frame_info{64, 30, 8, 3};
+
+        const auto encode = [&frame_info](jpegls_encoder& encoder, const vector<uint8_t>& source) {
+            encoder.frame_info(frame_info).interleave_mode(interleave_mode::line).color_transformation(color_transformation::hp1);
+            vector<uint8_t> destination(encoder.estimated_destination_size());
+            encoder.destination(destination);
+            destination.resize(encoder.encode(source));
+            return destination;
+        };
+
+        jpegls_encoder encoder;
+        const vector<uint8_t> destination1{encode(encoder, source1)};
+        encoder.reset();
+        const vector<uint8_t> destination2{encode(encoder, source2)};
+
+        jpegls_encoder new_encoder1;
+        jpegls_encoder new_encoder2;
+        Assert::IsTrue(destination1 == encode(new_encoder1, source1));
+        Assert::IsTrue(destination2 == encode(new_encoder2, source2));
+    }
+
+    TEST_METHOD(encode_after_reset_with_other_frame_info) // NOLINT
+    {
+        const vector<uint8_t> source1{create_test_image(64, 30, 1)};
+        const vector<uint8_t> source2{create_test_image(33, 17, 1)};
+        const frame_info frame_info1{64, 30, 8, 1};
+        const frame_info frame_info2{33, 17, 8, 1};
+
+        jpegls_encoder encoder;
+        encoder.frame_info(frame_info1);
+        vector<uint8_t> destination1(encoder.estimated_destination_size());
+        encoder.destination(destination1);
+        destination1.resize(encoder.encode(source1));
+
+        encoder.reset().frame_info(frame_info2);
+        vector<uint8_t> destination2(encoder.estimated_destination_size());
+        encoder.destination(destination2);
+        destination2.resize(encoder.encode(source2));
+
+        test_by_decoding(destination1, frame_info1, source1.data(), source1.size(), interleave_mode::none);
+        test_by_decoding(destination2, frame_info2, source2.data(), source2.size(), interleave_mode::none);
+    }
+
+    TEST_METHOD(encode_without_reset_throws) // NOLINT
+    {
+        const vector<uint8_t> source{create_test_image(16, 16, 1)};
+
+        jpegls_encoder encoder;
+        encoder.frame_info({16, 16, 8, 1});
+        vector<uint8_t> destination(encoder.estimated_destination_size());
+        encoder.destination(destination);
+        static_cast<void>(encoder.encode(source));
+
+        assert_expect_exception(jpegls_errc::invalid_operation,
+            [&] { static_cast<void>(encoder.destination(destination)); });
+    }
+
+    TEST_METHOD(encode_with_allocator) // NOLINT
+    {
+        const vector<uint8_t> source{create_test_image(64, 30, 3)};
+        const frame_info frame_info{64, 30, 8, 3};
+        const vector<uint8_t> expected{jpegls_encoder::encode(source, frame_info, interleave_mode::line)};
+
+        counting_allocator allocator;
+        {
+            jpegls_encoder encoder;
+            encoder.allocator(allocator.allocator()).frame_info(frame_info).interleave_mode(interleave_mode::line);
+            vector<uint8_t> destination(encoder.estimated_destination_size());
+            encoder.destination(destination);
+            destination.resize(encoder.encode(source));
+
+            Assert::IsTrue(expected == destination);
+            Assert::IsTrue(allocator.allocation_count > 0);
+            Assert::IsTrue(allocator.bytes_in_use > 0);
+
+            // The next image reuses the buffers of the previous image.
+            const size_t allocation_count{allocator.allocation_count};
+            encoder.reset();
+            encoder.destination(destination);
+            destination.resize(encoder.encode(source));
+            Assert::IsTrue(expected == destination);
+            Assert::AreEqual(allocation_count, allocator.allocation_count);
+        }
+
+        Assert::AreEqual(size_t{0}, allocator.bytes_in_use);
+    }
+
+    TEST_METHOD(encode_with_allocator_and_multiple_threads) // NOLINT
+    {
+        // The scans of the 2nd and 3rd component are encoded in scratch buffers, which must also use the allocator.
+        const vector<uint8_t> source{create_test_image(64, 30, 3)};
+        const frame_info frame_info{64, 30, 8, 3};
+        const vector<uint8_t> expected{jpegls_encoder::encode(source, frame_info, interleave_mode::none)};
+
+        counting_allocator allocator;
+        jpegls_encoder encoder1;
+        encoder1.allocator(allocator.allocator()).frame_info(frame_info).collect_error_metrics(true);
+        vector<uint8_t> destination1(encoder1.estimated_destination_size());
+        encoder1.destination(destination1);
+        destination1.resize(encoder1.encode(source));
+        const size_t single_thread_bytes_in_use{allocator.bytes_in_use};
+
+        jpegls_encoder encoder2;
+        encoder2.allocator(allocator.allocator()).frame_info(frame_info).collect_error_metrics(true).maximum_thread_count(3);
+        vector<uint8_t> destination2(encoder2.estimated_destination_size());
+        encoder2.destination(destination2);
+        destination2.resize(encoder2.encode(source));
+
+        Assert::IsTrue(expected == destination1);
+        Assert::IsTrue(expected == destination2);
+        Assert::IsTrue(allocator.bytes_in_use - single_thread_bytes_in_use >= 2 * source.size() / 3);
+
+        // Replacing the allocator releases the memory that was allocated with it.
+        encoder1.allocator({});
+        encoder2.allocator({});
+        Assert::AreEqual(size_t{0}, allocator.bytes_in_use);
+    }
+
+    TEST_METHOD(encode_with_multiple_threads_after_reset_reuses_codecs) // NOLINT
+    {
+        // Every stripe of restart intervals and every component scan keeps its codec for the next image.
+        const vector<uint8_t> source{create_test_image(64, 30, 3)};
+        const frame_info frame_info{64, 30, 8, 3};
+
+        for (const uint32_t restart_interval : {0U, 4U})
+        {
+            counting_allocator allocator;
+            jpegls_encoder encoder;
+            encoder.allocator(allocator.allocator()).frame_info(frame_info).restart_interval(restart_interval).maximum_thread_count(3);
+            vector<uint8_t> destination1(encoder.estimated_destination_size());
+            encoder.destination(destination1);
+            destination1.resize(encoder.encode(source));
+            const size_t allocation_count{allocator.allocation_count};
+
+            encoder.reset();
+            vector<uint8_t> destination2(destination1.size());
+            encoder.destination(destination2);
+            destination2.resize(encoder.encode(source));
+
+            Assert::IsTrue(destination1 == destination2);
+            Assert::AreEqual(allocation_count, allocator.allocation_count);
+        }
+    }
+
+    TEST_METHOD(set_allocator_without_deallocate_throws) // NOLINT
+    {
+        jpegls_encoder encoder;
+        charls::allocator allocator{counting_allocator().allocator()};
+        allocator.deallocate = nullptr;
+
+        assert_expect_exception(jpegls_errc::invalid_argument,
+            [&] { static_cast<void>(encoder.allocator(allocator)); });
+    }
+
+    TEST_METHOD(maximum_thread_count_negative_throws) // NOLINT
+    {
+        jpegls_encoder encoder;
+
+        assert_expect_exception(jpegls_errc::invalid_argument,
+            [&] { static_cast<void>(encoder.maximum_thread_count(-1)); });
+    }
+
+    TEST_METHOD(encode_collects_error_metrics) // NOLINT
+    {
+        const vector<uint8_t> source{create_test_image(64, 30, 3)};
+        const frame_info frame_info{64, 30, 8, 3};
+
+        jpegls_encoder encoder;
+        encoder.frame_info(frame_info).interleave_mode(interleave_mode::line).near_lossless(2).collect_error_metrics(true);
+        vector<uint8_t> destination(encoder.estimated_destination_size());
+        encoder.destination(destination);
+        destination.resize(encoder.encode(source));
+
+        jpegls_decoder decoder;
+        decoder.source(destination);
+        decoder.read_header();
+        vector<uint8_t> decoded(decoder.destination_size());
+        decoder.decode(decoded);
+
+        for (int32_t component = 0; component < frame_info.component_count; ++component)
+        {
+            uint64_t sum_squared_error{};
+            int32_t maximum_error{};
+            vector<uint64_t> expected_histogram(5);
+            for (size_t line = 0; line < frame_info.height; ++line)
+            {
+                for (size_t i = 0; i < frame_info.width; ++i)
+                {
+                    const size_t index = (line * frame_info.width + i) * frame_info.component_count + component;
+                    const int32_t error_value = source[index] - decoded[index];
+                    sum_squared_error += static_cast<uint64_t>(error_value * error_value);
+                    maximum_error = std::max(maximum_error, std::abs(error_value));
+                    ++expected_histogram[static_cast<size_t>(error_value + 2)];
+                }
+            }
+
+            const component_error_metrics metrics{encoder.error_metrics(component)};
+            Assert::AreEqual(static_cast<uint64_t>(frame_info.width) * frame_info.height, metrics.sample_count);
+            Assert::AreEqual(sum_squared_error, metrics.sum_squared_error);
+            Assert::AreEqual(maximum_error, metrics.maximum_error);
+            Assert::AreEqual(2, metrics.near_lossless);
+
+            // The error value is source - reconstructed, entry 0 is error value -NEAR.
+            const vector<uint64_t> histogram{encoder.error_histogram(component)};
+            Assert::AreEqual(static_cast<size_t>(5), histogram.size());
+            Assert::IsTrue(expected_histogram == histogram);
+        }
+    }
+
+    TEST_METHOD(error_metrics_of_lossless_encoding) // NOLINT
+    {
+        const vector<uint8_t> source{create_test_image(16, 8, 1)};
+
+        jpegls_encoder encoder;
+        encoder.frame_info({16, 8, 8, 1}).collect_error_metrics(true);
+        vector<uint8_t> destination(encoder.estimated_destination_size());
+        encoder.destination(destination);
+        static_cast<void>(encoder.encode(source));
+
+        const component_error_metrics metrics{encoder.error_metrics(0)};
+        Assert::AreEqual(static_cast<uint64_t>(16 * 8), metrics.sample_count);
+        Assert::AreEqual(static_cast<uint64_t>(0), metrics.sum_squared_error);
+        Assert::AreEqual(0, metrics.maximum_error);
+        Assert::IsTrue(std::isinf(metrics.peak_signal_to_noise_ratio));
+    }
+
+    TEST_METHOD(error_metrics_are_independent_of_thread_count) // NOLINT
+    {
+        const vector<uint8_t> source{create_test_image(64, 30, 3)};
+        const frame_info frame_info{64, 30, 8, 3};
+
+        for (const auto interleave_mode : {interleave_mode::none, interleave_mode::sample})
+        {
+            jpegls_encoder encoder1;
+            encoder1.frame_info(frame_info).interleave_mode(interleave_mode).near_lossless(3).restart_interval(4).collect_error_metrics(true);
+            vector<uint8_t> destination1(encoder1.estimated_destination_size());
+            encoder1.destination(destination1);
+            static_cast<void>(encoder1.encode(source));
+
+            jpegls_encoder encoder2;
+            encoder2.frame_info(frame_info).interleave_mode(interleave_mode).near_lossless(3).restart_interval(4).maximum_thread_count(3).collect_error_metrics(true);
+            vector<uint8_t> destination2(encoder2.estimated_destination_size());
+            encoder2.destination(destination2);
+            static_cast<void>(encoder2.encode(source));
+
+            for (int32_t component = 0; component < frame_info.component_count; ++component)
+            {
+                Assert::IsTrue(encoder1.error_histogram(component) == encoder2.error_histogram(component));
+            }
+        }
+    }
+
+    TEST_METHOD(error_metrics_without_collect_throws) // NOLINT
+    {
+        const vector<uint8_t> source{0, 1, 2, 3, 4, 5};
+        const frame_info frame_info{3, 2, 8, 1};
+
+        jpegls_encoder encoder;
+        encoder.frame_info(frame_info);
+        vector<uint8_t> destination(encoder.estimated_destination_size());
+        encoder.destination(destination);
+        static_cast<void>(encoder.encode(source));
+
+        assert_expect_exception(jpegls_errc::invalid_operation,
+            [&] { static_cast<void>(encoder.error_metrics(0)); });
+    }
+
+    TEST_METHOD(error_metrics_with_bad_component_throws) // NOLINT
+    {
+        const vector<uint8_t> source{0, 1, 2, 3, 4, 5};
+        const frame_info frame_info{3, 2, 8, 1};
+
+        jpegls_encoder encoder;
+        encoder.frame_info(frame_info).near_lossless(1).collect_error_metrics(true);
+        vector<uint8_t> destination(encoder.estimated_destination_size());
+        encoder.destination(destination);
+        static_cast<void>(encoder.encode(source));
+
+        assert_expect_exception(jpegls_errc::invalid_argument,
+            [&] { static_cast<void>(encoder.error_metrics(1)); });
+    }
+
     TEST_METHOD(simple_encode) // NOLINT
     {
         const vector<uint8_t> source{0, 1, 2, 3, 4, 5};
@@ -528,6 +1059,31 @@ TEST_CLASS(jpegls_encoder_test)
     }
 
 private:
+    static vector<uint8_t> create_test_image(const size_t width, const size_t height, const size_t component_count)
+    {
+        vector<uint8_t> image(width * height * component_count);
+        for (size_t i = 0; i < image.size(); ++i)
+        {
+            image[i] = static_cast<uint8_t>(i * 7 / 3 + (i % 11) * 13);
+        }
+
+        return image;
+    }
+
+    static int count_marker(const vector<uint8_t>& encoded_source, const uint8_t marker_code)
+    {
+        int count{};
+        for (size_t i = 0; i + 1 < encoded_source.size(); ++i)
+        {
+            if (encoded_source[i] == 0xFF && encoded_source[i + 1] == marker_code)
+            {
+                ++count;
+            }
+        }
+
+        return count;
+    }
+
     static void test_by_decoding(const vector<uint8_t>& encoded_source, const frame_info& source_frame_info, const uint8_t* source, const size_t source_size, const charls::interleave_mode interleave_mode)
     {
         jpegls_decoder decoder;
@@ -41,6 +41,74 @@ TEST_CLASS(lossless_traits_test)
         }
     }
 
+    TEST_METHOD(TestTraits10bit) // NOLINT
+    {
+        using lossless_traits = LosslessTraits<uint16_t, 10>;
+        const auto traits1 = DefaultTraits<uint16_t, uint16_t>(1023,0);
+        const lossless_traits traits2;
+
+        Assert::IsTrue(traits1.LIMIT == traits2.LIMIT);
+        Assert::IsTrue(traits1.MAXVAL == traits2.MAXVAL);
+        Assert::IsTrue(traits1.RESET == traits2.RESET);
+        Assert::IsTrue(traits1.bpp == traits2.bpp);
+        Assert::IsTrue(traits1.qbpp == traits2.qbpp);
+
+        for (int i = -1024; i <= 1024; ++i)
+        {
+            Assert::IsTrue(traits1.ModuloRange(i) == lossless_traits::ModuloRange(i));
+            Assert::IsTrue(traits1.ComputeErrVal(i) == lossless_traits::ComputeErrVal(i));
+        }
+
+        for (int i = -2047; i <= 2047; ++i)
+        {
+            Assert::IsTrue(traits1.CorrectPrediction(i) == lossless_traits::CorrectPrediction(i));
+            Assert::IsTrue(traits1.IsNear(i,2) == lossless_traits::IsNear(i, 2));
+        }
+    }
+
+    TEST_METHOD(TestTraits14bit) // NOLINT
+    {
+        using lossless_traits = LosslessTraits<uint16_t, 14>;
+        const auto traits1 = DefaultTraits<uint16_t, uint16_t>(16383,0);
+        const lossless_traits traits2;
+
+        Assert::IsTrue(traits1.LIMIT == traits2.LIMIT);
+        Assert::IsTrue(traits1.MAXVAL == traits2.MAXVAL);
+        Assert::IsTrue(traits1.RESET == traits2.RESET);
+        Assert::IsTrue(traits1.bpp == traits2.bpp);
+        Assert::IsTrue(traits1.qbpp == traits2.qbpp);
+
+        for (int i = -16384; i <= 16384; ++i)
+        {
+            Assert::IsTrue(traits1.ModuloRange(i) == lossless_traits::ModuloRange(i));
+            Assert::IsTrue(traits1.ComputeErrVal(i) == lossless_traits::ComputeErrVal(i));
+        }
+
+        for (int i = -32767; i <= 32767; ++i)
+        {
+            Assert::IsTrue(traits1.CorrectPrediction(i) == lossless_traits::CorrectPrediction(i));
+            Assert::IsTrue(traits1.IsNear(i,2) == lossless_traits::IsNear(i, 2));
+        }
+    }
+
+    TEST_METHOD(TestTraitsTriplet10bit) // NOLINT
+    {
+        using lossless_traits = LosslessTraits<Triplet<uint16_t>, 10>;
+        const auto traits1 = DefaultTraits<uint16_t, Triplet<uint16_t>>(1023,0);
+
+        for (int px = 0; px <= 1023; px += 31)
+        {
+            for (int i = -1023; i <= 1023; ++i)
+            {
+                Assert::IsTrue(traits1.ComputeReconstructedSample(px, traits1.ComputeErrVal(i)) ==
+                               lossless_traits::ComputeReconstructedSample(px, lossless_traits::ComputeErrVal(i)));
+            }
+        }
+
+        Assert::IsTrue(lossless_traits::IsNear(Triplet<uint16_t>(1, 2, 3), Triplet<uint16_t>(1, 2, 3)));
+        Assert::IsFalse(lossless_traits::IsNear(Triplet<uint16_t>(1, 2, 3), Triplet<uint16_t>(1, 2, 4)));
+    }
+
     TEST_METHOD(TestTraits8bit) // NOLINT
     {
         using lossless_traits = LosslessTraits<uint8_t, 8>;
@@ -0,0 +1,74 @@
+// Copyright (c) Team CharLS.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "pch.h"
+
+#include "../src/default_traits.h"
+#include "../src/near_lossless_traits.h"
+
+using Microsoft::VisualStudio::CppUnitTestFramework::Assert;
+
+namespace charls {
+namespace test {
+
+namespace {
+
+template<typename NearLosslessTraits>
+void AssertEqualToDefaultTraits(const int32_t maxval)
+{
+    using sample = typename NearLosslessTraits::SAMPLE;
+    const DefaultTraits<sample, sample> traits1(maxval, NearLosslessTraits::NEAR);
+    const NearLosslessTraits traits2(maxval);
+
+    Assert::AreEqual(traits1.MAXVAL, traits2.MAXVAL);
+    Assert::AreEqual(traits1.RANGE, traits2.RANGE);
+    Assert::AreEqual(traits1.NEAR, static_cast<int32_t>(traits2.NEAR));
+    Assert::AreEqual(traits1.qbpp, traits2.qbpp);
+    Assert::AreEqual(traits1.bpp, traits2.bpp);
+    Assert::AreEqual(traits1.LIMIT, traits2.LIMIT);
+    Assert::AreEqual(traits1.RESET, traits2.RESET);
+
+    for (int32_t i = -maxval; i <= maxval; ++i)
+    {
+        Assert::IsTrue(traits1.ComputeErrVal(i) == traits2.ComputeErrVal(i));
+        Assert::IsTrue(traits1.IsNear(i, 2) == traits2.IsNear(i, 2));
+    }
+
+    for (int32_t predicted = 0; predicted <= maxval; predicted += 7)
+    {
+        for (int32_t error_value = -traits1.RANGE / 2; error_value < (traits1.RANGE + 1) / 2; ++error_value)
+        {
+            Assert::IsTrue(traits1.ComputeReconstructedSample(predicted, error_value) == traits2.ComputeReconstructedSample(predicted, error_value));
+        }
+    }
+}
+
+} // namespace
+
+// clang-format off
+
+TEST_CLASS(near_lossless_traits_test)
+{
+public:
+    TEST_METHOD(TestTraits8bit) // NOLINT
+    {
+        AssertEqualToDefaultTraits<NearLosslessTraits<uint8_t, uint8_t, 1>>(255);
+        AssertEqualToDefaultTraits<NearLosslessTraits<uint8_t, uint8_t, 2>>(255);
+        AssertEqualToDefaultTraits<NearLosslessTraits<uint8_t, uint8_t, 3>>(255);
+    }
+
+    TEST_METHOD(TestTraits12bit) // NOLINT
+    {
+        AssertEqualToDefaultTraits<NearLosslessTraits<uint16_t, uint16_t, 1>>(4095);
+        AssertEqualToDefaultTraits<NearLosslessTraits<uint16_t, uint16_t, 2>>(4095);
+        AssertEqualToDefaultTraits<NearLosslessTraits<uint16_t, uint16_t, 3>>(4095);
+    }
+
+    TEST_METHOD(TestTraitsNonPowerOfTwoMaxval) // NOLINT
+    {
+        AssertEqualToDefaultTraits<NearLosslessTraits<uint8_t, uint8_t, 3>>(200);
+    }
+};
+
+} // namespace test
+} // namespace charls
@@ -0,0 +1,186 @@
+// Copyright (c) Team CharLS.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "pch.h"
+
+#include "../src/pipelined_process_line.h"
+
+#include "util.h"
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+using Microsoft::VisualStudio::CppUnitTestFramework::Assert;
+using std::vector;
+
+namespace charls {
+namespace test {
+
+namespace {
+
+vector<uint8_t> create_component_lines(const size_t line, const int stride)
+{
+    vector<uint8_t> component_lines(static_cast<size_t>(3) * stride);
+    for (size_t i = 0; i < component_lines.size(); ++i)
+    {
+        component_lines[i] = static_cast<uint8_t>(line * 3 + i);
+    }
+
+    return component_lines;
+}
+
+class recording_process_line final : public ProcessLine
+{
+public:
+    explicit recording_process_line(vector<vector<uint8_t>>& lines, const size_t throw_at_line = SIZE_MAX) noexcept :
+        lines_{lines},
+        throw_at_line_{throw_at_line}
+    {
+    }
+
+    void NewLineDecoded(const void* pSrc, const int pixelCount, const int sourceStride) override
+    {
+        if (lines_.size() == throw_at_line_)
+            impl::throw_jpegls_error(jpegls_errc::destination_buffer_too_small);
+
+        // Records the first sample of every component line, the components are sourceStride samples apart.
+        const auto* source = static_cast<const uint8_t*>(pSrc);
+        lines_.push_back({source[0], source[pixelCount - 1], source[sourceStride], source[2 * sourceStride + pixelCount - 1]});
+    }
+
+    void NewLineRequested(void* pDest, const int pixelCount, const int destStride) override
+    {
+        if (requested_line_count_ == throw_at_line_)
+            impl::throw_jpegls_error(jpegls_errc::source_buffer_too_small);
+
+        const vector<uint8_t> component_lines{create_component_lines(requested_line_count_, destStride)};
+        auto* destination = static_cast<uint8_t*>(pDest);
+        for (size_t component = 0; component < 3; ++component)
+        {
+            std::copy_n(&component_lines[component * destStride], pixelCount, &destination[component * destStride]);
+        }
+        ++requested_line_count_;
+    }
+
+private:
+    vector<vector<uint8_t>>& lines_;
+    size_t throw_at_line_;
+    size_t requested_line_count_{};
+};
+
+} // namespace
+
+// clang-format off
+
+TEST_CLASS(pipelined_process_line_test)
+{
+public:
+    TEST_METHOD(lines_are_processed_in_order) // NOLINT
+    {
+        const frame_info frame_info{10, 100, 8, 3};
+        coding_parameters parameters{};
+        parameters.interleave_mode = interleave_mode::line;
+
+        constexpr int pixel_count = 10;
+        constexpr int stride = 14;
+        vector<vector<uint8_t>> lines;
+        PipelinedProcessLine pipeline(allocate_unique<recording_process_line>(charls_allocator{}, lines), frame_info, parameters);
+        for (size_t line = 0; line < frame_info.height; ++line)
+        {
+            const vector<uint8_t> component_lines{create_component_lines(line, stride)};
+            pipeline.NewLineDecoded(component_lines.data(), pixel_count, stride);
+        }
+        pipeline.Flush();
+
+        Assert::AreEqual(static_cast<size_t>(frame_info.height), lines.size());
+        for (size_t line = 0; line < lines.size(); ++line)
+        {
+            const vector<uint8_t> component_lines{create_component_lines(line, stride)};
+            Assert::AreEqual(component_lines[0], lines[line][0]);
+            Assert::AreEqual(component_lines[pixel_count - 1], lines[line][1]);
+            Assert::AreEqual(component_lines[stride], lines[line][2]);
+            Assert::AreEqual(component_lines[2 * stride + pixel_count - 1], lines[line][3]);
+        }
+    }
+
+    TEST_METHOD(exception_of_target_is_rethrown) // NOLINT
+    {
+        const frame_info frame_info{10, 100, 8, 3};
+        coding_parameters parameters{};
+        parameters.interleave_mode = interleave_mode::line;
+
+        constexpr int pixel_count = 10;
+        constexpr int stride = 14;
+        vector<vector<uint8_t>> lines;
+        const vector<uint8_t> component_lines{create_component_lines(0, stride)};
+
+        assert_expect_exception(jpegls_errc::destination_buffer_too_small, [&] {
+            PipelinedProcessLine pipeline(allocate_unique<recording_process_line>(charls_allocator{}, lines, 5), frame_info, parameters);
+            for (size_t line = 0; line < frame_info.height; ++line)
+            {
+                pipeline.NewLineDecoded(component_lines.data(), pixel_count, stride);
+            }
+            pipeline.Flush();
+        });
+
+        Assert::AreEqual(static_cast<size_t>(5), lines.size());
+    }
+
+    TEST_METHOD(requested_lines_are_prepared_in_order) // NOLINT
+    {
+        const frame_info frame_info{10, 100, 8, 3};
+        coding_parameters parameters{};
+        parameters.interleave_mode = interleave_mode::line;
+
+        constexpr int pixel_count = 10;
+        constexpr int stride = 14;
+        vector<vector<uint8_t>> lines;
+        PipelinedProcessLine pipeline(allocate_unique<recording_process_line>(charls_allocator{}, lines), frame_info, parameters);
+        for (size_t line = 0; line < frame_info.height; ++line)
+        {
+            vector<uint8_t> component_lines(static_cast<size_t>(3) * stride);
+            pipeline.NewLineRequested(component_lines.data(), pixel_count, stride);
+
+            const vector<uint8_t> expected{create_component_lines(line, stride)};
+            for (size_t component = 0; component < 3; ++component)
+            {
+                for (size_t i = 0; i < stride; ++i)
+                {
+                    // The padding after the samples of a component line must remain untouched.
+                    const size_t index = component * stride + i;
+                    Assert::AreEqual(i < pixel_count ? expected[index] : static_cast<uint8_t>(0), component_lines[index]);
+                }
+            }
+        }
+        pipeline.Flush();
+    }
+
+    TEST_METHOD(exception_of_target_is_rethrown_when_requesting) // NOLINT
+    {
+        const frame_info frame_info{10, 100, 8, 3};
+        coding_parameters parameters{};
+        parameters.interleave_mode = interleave_mode::line;
+
+        constexpr int pixel_count = 10;
+        constexpr int stride = 14;
+        vector<vector<uint8_t>> lines;
+        vector<uint8_t> component_lines(static_cast<size_t>(3) * stride);
+        size_t requested_line_count{};
+
+        assert_expect_exception(jpegls_errc::source_buffer_too_small, [&] {
+            PipelinedProcessLine pipeline(allocate_unique<recording_process_line>(charls_allocator{}, lines, 5), frame_info, parameters);
+            for (; requested_line_count < frame_info.height; ++requested_line_count)
+            {
+                pipeline.NewLineRequested(component_lines.data(), pixel_count, stride);
+            }
+            pipeline.Flush();
+        });
+
+        // The lines prepared before the failure are delivered first.
+        Assert::AreEqual(static_cast<size_t>(5), requested_line_count);
+    }
+};
+
+} // namespace test
+} // namespace charls
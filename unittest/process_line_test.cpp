@@ -0,0 +1,102 @@
+// Copyright (c) Team CharLS.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "pch.h"
+
+#include "../src/color_transform.h"
+#include "../src/process_line.h"
+
+#include <vector>
+
+using Microsoft::VisualStudio::CppUnitTestFramework::Assert;
+using std::vector;
+
+namespace charls {
+namespace test {
+
+namespace {
+
+// Transforms a line of pixels with the functions of every instruction set supported by the CPU, the result must be identical to the scalar code.
+template<typename Transform>
+void check_instruction_sets(const Transform& transform, const interleave_mode interleave_mode, const int32_t component_count = 3)
+{
+    using sample_type = typename Transform::size_type;
+
+    // Not a multiple of the vector size to also test the remaining pixels.
+    constexpr int width = 100 + 7;
+    const frame_info frame_info{width, 1, static_cast<int32_t>(sizeof(sample_type) * 8), component_count};
+    coding_parameters parameters{};
+    parameters.interleave_mode = interleave_mode;
+
+    vector<sample_type> source(static_cast<size_t>(width) * component_count);
+    for (size_t i = 0; i < source.size(); ++i)
+    {
+        source[i] = static_cast<sample_type>(i * 7919);
+    }
+
+    vector<sample_type> expected_encoded(source.size());
+    vector<sample_type> expected_decoded(source.size());
+    ProcessTransformed<Transform> scalar(FromByteArray(nullptr, 0), 0, frame_info, parameters, transform, simd_detail::scalar_simd_functions());
+    scalar.Transform(source.data(), expected_encoded.data(), width, width);
+    scalar.DecodeTransform(source.data(), expected_decoded.data(), width, width);
+
+    for (auto isa = instruction_set::baseline; isa <= detected_instruction_set();
+         isa = static_cast<instruction_set>(static_cast<int>(isa) + 1))
+    {
+        vector<sample_type> encoded(source.size());
+        vector<sample_type> decoded(source.size());
+        ProcessTransformed<Transform> process(FromByteArray(nullptr, 0), 0, frame_info, parameters, transform, get_simd_functions(isa));
+        process.Transform(source.data(), encoded.data(), width, width);
+        process.DecodeTransform(source.data(), decoded.data(), width, width);
+
+        Assert::IsTrue(expected_encoded == encoded);
+        Assert::IsTrue(expected_decoded == decoded);
+    }
+}
+
+} // namespace
+
+// clang-format off
+
+TEST_CLASS(process_line_test)
+{
+public:
+    TEST_METHOD(transform_hp1_is_identical_for_all_instruction_sets) // NOLINT
+    {
+        check_instruction_sets(TransformHp1<uint8_t>(), interleave_mode::line);
+        check_instruction_sets(TransformHp1<uint8_t>(), interleave_mode::sample);
+        check_instruction_sets(TransformHp1<uint16_t>(), interleave_mode::line);
+        check_instruction_sets(TransformHp1<uint16_t>(), interleave_mode::sample);
+    }
+
+    TEST_METHOD(transform_hp2_is_identical_for_all_instruction_sets) // NOLINT
+    {
+        check_instruction_sets(TransformHp2<uint8_t>(), interleave_mode::line);
+        check_instruction_sets(TransformHp2<uint8_t>(), interleave_mode::sample);
+        check_instruction_sets(TransformHp2<uint16_t>(), interleave_mode::line);
+        check_instruction_sets(TransformHp2<uint16_t>(), interleave_mode::sample);
+    }
+
+    TEST_METHOD(transform_hp3_is_identical_for_all_instruction_sets) // NOLINT
+    {
+        check_instruction_sets(TransformHp3<uint8_t>(), interleave_mode::line);
+        check_instruction_sets(TransformHp3<uint8_t>(), interleave_mode::sample);
+        check_instruction_sets(TransformHp3<uint16_t>(), interleave_mode::line);
+        check_instruction_sets(TransformHp3<uint16_t>(), interleave_mode::sample);
+    }
+
+    TEST_METHOD(transform_none_and_shifted_are_identical_for_all_instruction_sets) // NOLINT
+    {
+        check_instruction_sets(TransformNone<uint8_t>(), interleave_mode::line);
+        check_instruction_sets(TransformNone<uint8_t>(), interleave_mode::sample);
+        check_instruction_sets(TransformNone<uint16_t>(), interleave_mode::line);
+        check_instruction_sets(TransformNone<uint16_t>(), interleave_mode::sample);
+        check_instruction_sets(TransformNone<uint8_t>(), interleave_mode::line, 4);
+        check_instruction_sets(TransformNone<uint8_t>(), interleave_mode::sample, 4);
+        check_instruction_sets(TransformShifted<TransformHp1<uint16_t>>(4), interleave_mode::line);
+        check_instruction_sets(TransformShifted<TransformHp1<uint16_t>>(4), interleave_mode::sample);
+    }
+};
+
+} // namespace test
+} // namespace charls
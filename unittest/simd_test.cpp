@@ -0,0 +1,168 @@
+// Copyright (c) Team CharLS.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "pch.h"
+
+#include "../src/simd.h"
+
+#include <vector>
+
+using Microsoft::VisualStudio::CppUnitTestFramework::Assert;
+using std::vector;
+
+namespace charls {
+namespace test {
+
+namespace {
+
+// Returns the functions of every instruction set supported by the CPU and the scalar functions.
+vector<simd_functions> supported_simd_functions()
+{
+    vector<simd_functions> functions{simd_detail::scalar_simd_functions()};
+    for (auto isa = instruction_set::baseline; isa <= detected_instruction_set(); isa = static_cast<instruction_set>(static_cast<int>(isa) + 1))
+    {
+        functions.push_back(get_simd_functions(isa));
+    }
+
+    return functions;
+}
+
+} // namespace
+
+// clang-format off
+
+TEST_CLASS(simd_test)
+{
+public:
+    TEST_METHOD(find_jpeg_marker_start_byte_in_empty_range) // NOLINT
+    {
+        const vector<uint8_t> buffer(1);
+
+        Assert::IsTrue(buffer.data() == find_jpeg_marker_start_byte(buffer.data(), buffer.data()));
+    }
+
+    TEST_METHOD(find_jpeg_marker_start_byte_not_present) // NOLINT
+    {
+        const vector<uint8_t> buffer(100, 0xFE);
+
+        Assert::IsTrue(buffer.data() + buffer.size() == find_jpeg_marker_start_byte(buffer.data(), buffer.data() + buffer.size()));
+    }
+
+    TEST_METHOD(find_jpeg_marker_start_byte_at_every_position) // NOLINT
+    {
+        // Covers the vector steps, the scalar tail and every position within a vector.
+        for (size_t size = 1; size < 80; ++size)
+        {
+            for (size_t position = 0; position < size; ++position)
+            {
+                vector<uint8_t> buffer(size, 0x7F);
+                buffer[position] = 0xFF;
+                if (position + 1 < size)
+                {
+                    buffer.back() = 0xFF;
+                }
+
+                Assert::IsTrue(buffer.data() + position == find_jpeg_marker_start_byte(buffer.data(), buffer.data() + buffer.size()));
+            }
+        }
+    }
+
+    TEST_METHOD(count_equal_values_8_bit) // NOLINT
+    {
+        // Covers the vector steps, the scalar tail and every position within a vector.
+        for (size_t size = 0; size < 80; ++size)
+        {
+            for (size_t position = 0; position <= size; ++position)
+            {
+                vector<uint8_t> buffer(size, 0x55);
+                if (position < size)
+                {
+                    buffer[position] = 0x54;
+                }
+
+                Assert::AreEqual(position, count_equal_values(buffer.data(), buffer.size(), static_cast<uint8_t>(0x55)));
+            }
+        }
+    }
+
+    TEST_METHOD(count_equal_values_16_bit) // NOLINT
+    {
+        for (size_t size = 0; size < 40; ++size)
+        {
+            for (size_t position = 0; position <= size; ++position)
+            {
+                vector<uint16_t> buffer(size, 0x1234);
+                if (position < size)
+                {
+                    buffer[position] = 0x1334; // only the high byte differs.
+                }
+
+                Assert::AreEqual(position, count_equal_values(buffer.data(), buffer.size(), static_cast<uint16_t>(0x1234)));
+            }
+        }
+    }
+
+    TEST_METHOD(find_jpeg_marker_start_byte_for_all_instruction_sets) // NOLINT
+    {
+        for (const auto& functions : supported_simd_functions())
+        {
+            for (size_t size = 1; size < 80; ++size)
+            {
+                for (size_t position = 0; position <= size; ++position)
+                {
+                    vector<uint8_t> buffer(size, 0xFE);
+                    if (position < size)
+                    {
+                        buffer[position] = 0xFF;
+                    }
+
+                    Assert::IsTrue(buffer.data() + position == functions.find_jpeg_marker_start_byte(buffer.data(), buffer.data() + buffer.size()));
+                }
+            }
+        }
+    }
+
+    TEST_METHOD(count_equal_values_for_all_instruction_sets) // NOLINT
+    {
+        for (const auto& functions : supported_simd_functions())
+        {
+            for (size_t size = 0; size < 80; ++size)
+            {
+                for (size_t position = 0; position <= size; ++position)
+                {
+                    vector<uint8_t> buffer8(size, 0x55);
+                    vector<uint16_t> buffer16(size, 0x1234);
+                    if (position < size)
+                    {
+                        buffer8[position] = 0x54;
+                        buffer16[position] = 0x1334;
+                    }
+
+                    Assert::AreEqual(position, functions.count_equal_values_8(buffer8.data(), buffer8.size(), static_cast<uint8_t>(0x55)));
+                    Assert::AreEqual(position, functions.count_equal_values_16(buffer16.data(), buffer16.size(), static_cast<uint16_t>(0x1234)));
+                }
+            }
+        }
+    }
+
+    TEST_METHOD(countr_zero_values) // NOLINT
+    {
+        Assert::AreEqual(32, countr_zero(0U));
+        Assert::AreEqual(0, countr_zero(1U));
+        Assert::AreEqual(31, countr_zero(0x80000000U));
+        Assert::AreEqual(64, countr_zero(uint64_t{0}));
+        Assert::AreEqual(40, countr_zero(uint64_t{1} << 40));
+    }
+
+    TEST_METHOD(countl_zero_values) // NOLINT
+    {
+        Assert::AreEqual(32, countl_zero(0U));
+        Assert::AreEqual(31, countl_zero(1U));
+        Assert::AreEqual(0, countl_zero(0x80000000U));
+        Assert::AreEqual(64, countl_zero(uint64_t{0}));
+        Assert::AreEqual(23, countl_zero(uint64_t{1} << 40));
+    }
+};
+
+} // namespace test
+} // namespace charls
@@ -71,5 +71,32 @@ void assert_expect_exception(const jpegls_errc error_value, Functor functor)
     Microsoft::VisualStudio::CppUnitTestFramework::Assert::Fail();
 }
 
+// Allocator that counts the allocations and the bytes in use, to test the allocator of the encoder and decoder.
+struct counting_allocator final
+{
+    size_t allocation_count{};
+    size_t bytes_in_use{};
+
+    charls::allocator allocator() noexcept
+    {
+        return {allocate, deallocate, this};
+    }
+
+private:
+    static void* CHARLS_API_CALLING_CONVENTION allocate(void* user_context, const size_t size, size_t /*alignment*/)
+    {
+        auto* const self = static_cast<counting_allocator*>(user_context);
+        ++self->allocation_count;
+        self->bytes_in_use += size;
+        return ::operator new(size);
+    }
+
+    static void CHARLS_API_CALLING_CONVENTION deallocate(void* user_context, void* memory, const size_t size, size_t /*alignment*/)
+    {
+        static_cast<counting_allocator*>(user_context)->bytes_in_use -= size;
+        ::operator delete(memory);
+    }
+};
+
 }
 } // namespace charls::test